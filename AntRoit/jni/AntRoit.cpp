@@ -15,50 +15,72 @@
 */
 
 // OpenGL ES 2.0 code
+//
+// Define ANTROIT_HEADLESS to build without JNI, EGL or GLES2. The frame loop
+// then renders into the in-memory RecorderBackend and main() drives it.
 
+#ifndef ANTROIT_HEADLESS
 #include <jni.h>
 #include <android/log.h>
 
+#include <EGL/egl.h>
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
+#endif
 
+#include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include <vector>
-#include <glm\glm.hpp>
-#include <glm\gtc\type_ptr.hpp>
-#include <glm\gtx\transform.hpp>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtx/transform.hpp>
 
 #include <random>
+#include <algorithm>
 
-#include <Box2D\Box2D.h>
+#include <Box2D/Box2D.h>
 
-#pragma region GL debug
+#pragma region Logging
 
+#ifndef ANTROIT_HEADLESS
 #define  LOG_TAG    "AntRoit"
 #define  LOGI(...)  __android_log_print(ANDROID_LOG_INFO,LOG_TAG,__VA_ARGS__)
 #define  LOGE(...)  __android_log_print(ANDROID_LOG_ERROR,LOG_TAG,__VA_ARGS__)
-#define randomFloat std::uniform_real_distribution<float>
+#else
+#define  LOGI(...)  printf(__VA_ARGS__)
+#define  LOGE(...)  fprintf(stderr, __VA_ARGS__)
+#endif
 
-static void printGLString(const char *name, GLenum s) 
-{
-	const char *v = (const char *)glGetString(s);
-	LOGI("GL %s = %s\n", name, v);
-}
+#pragma endregion
 
-static void checkGlError(const char* op) 
+#pragma region Globals
+
+// Uniform float in [low, high). Unlike std::uniform_real_distribution the
+// result is specified exactly, so a recorded seed replays the same scene.
+struct RandomFloat
 {
-	for (GLint error = glGetError(); error; error
-		= glGetError()) {
-		LOGI("after %s() glError (0x%x)\n", op, error);
-	}
-}
+	RandomFloat(float low, float high) : low(low), high(high) {}
 
-#pragma endregion
+	template <class Generator>
+	float operator()(Generator& generator) const
+	{
+		float unit = (unsigned int)(generator() >> 8) * (1.0f / 16777216.0f);
+		return low + (high - low) * unit;
+	}
 
-#pragma region Globals
+	float low, high;
+};
 
 static const float Scale = 16.0f;
 
@@ -96,30 +118,137 @@ float box2DToWorld(float f)
 	return f * Scale;
 }
 
-GLuint program;
+unsigned int program = 0;
+int mvpLocation = -1;
 glm::mat4 projection;
+// Top-left corner of the view in world pixels.
+glm::vec2 camera(0.0f, 0.0f);
 b2World world(b2Vec2(0.0f, worldToBox2D(128.0f)));
+// Simulated seconds, advanced by every step.
+float currentTime = 0.0f;
 
 #pragma endregion
 
 #pragma region Shaders
 
+// Color is a vertex attribute so the batch can stream it per vertex.
+// Positions arrive as fixed point relative to the view, with the shape's
+// layer in z; MVP undoes both.
 static const char vertexShader[] =
-"attribute vec2 position;\n"
+"attribute vec3 position;\n"
+"attribute vec4 color;\n"
 "uniform mat4 MVP;\n"
+"varying vec4 vColor;\n"
 "void main()\n"
 "{\n"
-"	gl_Position = MVP * vec4(position, 0.0, 1.0);\n"
+"	vColor = color;\n"
+"	gl_Position = MVP * vec4(position, 1.0);\n"
 "}\n";
 
 static const char fragmentShader[] =
 "precision mediump float;\n"
-"uniform vec4 color;\n"
+"varying vec4 vColor;\n"
 "void main()\n"
 "{\n"
-"	gl_FragColor = color;\n"
+"	gl_FragColor = vColor;\n"
 "}\n";
 
+static const unsigned int PositionAttribute = 0;
+static const unsigned int ColorAttribute = 1;
+
+#pragma endregion
+
+#pragma region Render backend
+
+struct RenderStats
+{
+	unsigned int drawCalls;
+	unsigned int vertices;
+	unsigned int bytesUploaded;
+};
+
+enum BufferUsage
+{
+	StaticDraw,
+	DynamicDraw,
+	StreamDraw
+};
+
+enum AttributeType
+{
+	FloatAttribute,
+	ShortAttribute,
+	UnsignedByteAttribute
+};
+
+// Everything the frame loop asks of the GPU goes through this interface, so
+// the same scene code can render through GLES2 on device or into the
+// recorder on a desktop. Buffer calls act on the currently bound array
+// buffer, as in GL.
+struct RenderBackend
+{
+	RenderBackend() : stats() {}
+	virtual ~RenderBackend() {}
+
+	virtual void describe() = 0;
+
+	// Identifies the driver; program binaries only load on the one that
+	// produced them.
+	virtual std::string driverName() = 0;
+
+	virtual unsigned int createProgram(const char* vertexSource, const char* fragmentSource) = 0;
+
+	// Both return false/0 when the driver cannot save or load binaries.
+	virtual bool getProgramBinary(unsigned int program, std::vector<unsigned char>& binary, unsigned int& format) = 0;
+	virtual unsigned int createProgramFromBinary(unsigned int format, const std::vector<unsigned char>& binary) = 0;
+
+	virtual int getUniformLocation(unsigned int program, const char* name) = 0;
+	virtual void useProgram(unsigned int program) = 0;
+
+	virtual unsigned int createBuffer() = 0;
+	virtual void deleteBuffer(unsigned int buffer) = 0;
+	virtual void bindBuffer(unsigned int buffer) = 0;
+	virtual void bufferData(size_t size, const void* data, BufferUsage usage) = 0;
+	virtual void bufferSubData(size_t offset, size_t size, const void* data) = 0;
+
+	virtual void enableAttribute(unsigned int index) = 0;
+	virtual void disableAttribute(unsigned int index) = 0;
+	virtual void attributePointer(unsigned int index, int size, AttributeType type, bool normalized, int stride, size_t offset) = 0;
+	virtual void constantAttribute(unsigned int index, const float* value) = 0;
+	virtual void uniformMatrix(int location, const float* value) = 0;
+
+	virtual void viewport(int x, int y, int width, int height) = 0;
+	virtual void clearColor(float r, float g, float b, float a) = 0;
+	virtual void clear() = 0;
+	virtual void setDepthTest(bool enabled) = 0;
+	virtual void setDepthWrite(bool enabled) = 0;
+	virtual void setBlending(bool enabled) = 0;
+
+	virtual void drawTriangles(int first, int count) = 0;
+
+	RenderStats stats;
+};
+
+#pragma endregion
+
+#ifndef ANTROIT_HEADLESS
+
+#pragma region GL debug
+
+static void printGLString(const char *name, GLenum s) 
+{
+	const char *v = (const char *)glGetString(s);
+	LOGI("GL %s = %s\n", name, v);
+}
+
+static void checkGlError(const char* op) 
+{
+	for (GLint error = glGetError(); error; error
+		= glGetError()) {
+		LOGI("after %s() glError (0x%x)\n", op, error);
+	}
+}
+
 #pragma endregion
 
 #pragma region Shader loading
@@ -172,6 +301,9 @@ GLuint createProgram(const char* vertexSource, const char* fragmentSource)
 		glAttachShader(program, vertexShader);
 		glAttachShader(program, fragmentShader);
 
+		glBindAttribLocation(program, PositionAttribute, "position");
+		glBindAttribLocation(program, ColorAttribute, "color");
+
 		glLinkProgram(program);
 
 		GLint linkStatus = GL_FALSE;
@@ -201,352 +333,3854 @@ GLuint createProgram(const char* vertexSource, const char* fragmentSource)
 
 #pragma endregion
 
-#pragma region Shapes
+#pragma region GLES2 backend
 
-struct Shape
+struct GLES2Backend : public RenderBackend
 {
-	Shape(const glm::vec4& color, b2World& world) : 
-		color(color), 
-		model(1.0f), 
-		world(world), 
-		numVertices(0)
+	GLES2Backend() : getProgramBinaryOES(nullptr), programBinaryOES(nullptr) {}
+
+	void describe()
 	{
-		glGenBuffers(1, &VBO);
+		printGLString("Version", GL_VERSION);
+		printGLString("Vendor", GL_VENDOR);
+		printGLString("Renderer", GL_RENDERER);
+		printGLString("Extensions", GL_EXTENSIONS);
 	}
 
-	~Shape()
+	std::string driverName()
 	{
-		world.DestroyBody(body);
-		body = nullptr;
+		std::string name;
+		name += (const char*)glGetString(GL_VENDOR);
+		name += '/';
+		name += (const char*)glGetString(GL_RENDERER);
+		name += '/';
+		name += (const char*)glGetString(GL_VERSION);
+		return name;
+	}
 
-		glDeleteBuffers(1, &VBO);
+	unsigned int createProgram(const char* vertexSource, const char* fragmentSource)
+	{
+		return ::createProgram(vertexSource, fragmentSource);
 	}
 
-	void draw()
+	bool getProgramBinary(unsigned int program, std::vector<unsigned char>& binary, unsigned int& format)
 	{
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		if (!loadProgramBinaryFunctions()) return false;
 
-		glEnableVertexAttribArray(0);
+		GLint length = 0;
+		glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+		if (length <= 0) return false;
 
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), 0);
+		binary.resize(length);
 
-		glm::mat4 model = glm::translate(glm::vec3(box2DToWorld(body->GetPosition().x), box2DToWorld(body->GetPosition().y), 0.0f));
-		model *= glm::rotate(body->GetAngle(), glm::vec3(0.0f, 0.0f, 1.0f));
+		GLsizei written = 0;
+		GLenum binaryFormat = 0;
+		getProgramBinaryOES(program, length, &written, &binaryFormat, &binary[0]);
+		checkGlError("glGetProgramBinaryOES");
 
-		glUniform4fv(glGetUniformLocation(program, "color"), 1, glm::value_ptr(color));
-		glUniformMatrix4fv(glGetUniformLocation(program, "MVP"), 1, GL_FALSE, glm::value_ptr(projection * model));
+		binary.resize(written);
+		format = binaryFormat;
+		return written > 0;
+	}
+
+	unsigned int createProgramFromBinary(unsigned int format, const std::vector<unsigned char>& binary)
+	{
+		if (!loadProgramBinaryFunctions() || binary.empty()) return 0;
+
+		GLuint program = glCreateProgram();
+		if (!program) return 0;
 
-		glDrawArrays(GL_TRIANGLES, 0, numVertices);
+		programBinaryOES(program, format, &binary[0], binary.size());
 
-		glDisableVertexAttribArray(0);
+		// A driver update or a different GPU rejects the binary here.
+		GLint linkStatus = GL_FALSE;
+		glGetProgramiv(program, GL_LINK_STATUS, &linkStatus);
+		if (linkStatus != GL_TRUE)
+		{
+			glDeleteProgram(program);
+			return 0;
+		}
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return program;
 	}
 
-	void setGravity(float gravity)
+	int getUniformLocation(unsigned int program, const char* name)
 	{
-		body->SetGravityScale(gravity);
+		return glGetUniformLocation(program, name);
 	}
 
-protected:
-
-	glm::mat4 model;
-	glm::vec4 color;
-	b2World& world;
-	b2Body* body;
-	GLuint VBO;
-	GLuint numVertices;
-};
-
-struct Triangle : public Shape
-{
-	Triangle(GLfloat x, GLfloat y, GLfloat width, GLfloat height, GLfloat rotation, const glm::vec4& color, b2World &world, bool dynamic) : Shape(color, world)
+	void useProgram(unsigned int program)
 	{
-		b2BodyDef bodyDef;
-		bodyDef.position = worldToBox2D(x, y);;
+		glUseProgram(program);
+	}
 
-		bodyDef.type = dynamic ? b2_dynamicBody : b2_staticBody;
-		body = world.CreateBody(&bodyDef);
+	unsigned int createBuffer()
+	{
+		GLuint buffer = 0;
+		glGenBuffers(1, &buffer);
+		return buffer;
+	}
 
-		b2PolygonShape shape;
-		b2Vec2 shapetices[3];
+	void deleteBuffer(unsigned int buffer)
+	{
+		GLuint handle = buffer;
+		glDeleteBuffers(1, &handle);
+	}
 
-		shapetices[0].Set(-worldToBox2D(width / 2.0f), worldToBox2D(height / 2.0f));
-		shapetices[1].Set(worldToBox2D(width / 2.0f), worldToBox2D(height / 2.0f));
-		shapetices[2].Set(-worldToBox2D(width / 2.0f), -worldToBox2D(height / 2.0f));
+	void bindBuffer(unsigned int buffer)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	}
 
-		shape.Set(shapetices, 3);
+	void bufferData(size_t size, const void* data, BufferUsage usage)
+	{
+		static const GLenum usages[] = { GL_STATIC_DRAW, GL_DYNAMIC_DRAW, GL_STREAM_DRAW };
+		glBufferData(GL_ARRAY_BUFFER, size, data, usages[usage]);
+		if (data) stats.bytesUploaded += size;
+	}
 
-		b2FixtureDef fixtureDef;
-		fixtureDef.friction = 1.0f;
-		fixtureDef.density = 1.0f;
-		fixtureDef.shape = &shape;
+	void bufferSubData(size_t offset, size_t size, const void* data)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+		stats.bytesUploaded += size;
+	}
 
-		body->CreateFixture(&fixtureDef);
+	void enableAttribute(unsigned int index)
+	{
+		glEnableVertexAttribArray(index);
+	}
 
-		body->SetTransform(body->GetPosition(), rotation);
+	void disableAttribute(unsigned int index)
+	{
+		glDisableVertexAttribArray(index);
+	}
 
-		numVertices = 3;
+	void attributePointer(unsigned int index, int size, AttributeType type, bool normalized, int stride, size_t offset)
+	{
+		static const GLenum types[] = { GL_FLOAT, GL_SHORT, GL_UNSIGNED_BYTE };
+		glVertexAttribPointer(index, size, types[type], normalized ? GL_TRUE : GL_FALSE, stride, (const GLvoid*)offset);
+	}
 
-		GLfloat vertices[] = {
-			-width / 2.0f, height / 2.0f,
-			width / 2.0f, height / 2.0f,
-			-width / 2.0f, -height / 2.0f,
-		};
+	void constantAttribute(unsigned int index, const float* value)
+	{
+		glVertexAttrib4fv(index, value);
+		stats.bytesUploaded += 4 * sizeof(GLfloat);
+	}
 
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	void uniformMatrix(int location, const float* value)
+	{
+		glUniformMatrix4fv(location, 1, GL_FALSE, value);
+		stats.bytesUploaded += 16 * sizeof(GLfloat);
+	}
 
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+	void viewport(int x, int y, int width, int height)
+	{
+		glViewport(x, y, width, height);
+	}
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	void clearColor(float r, float g, float b, float a)
+	{
+		glClearColor(r, g, b, a);
 	}
-};
 
-struct Rectangle : public Shape
-{
-	Rectangle(GLfloat x, GLfloat y, GLfloat width, GLfloat height, GLfloat rotation, const glm::vec4& color, b2World &world, bool dynamic) : Shape(color, world)
+	void clear()
 	{
-		b2BodyDef bodyDef;
-		bodyDef.position = worldToBox2D(x, y);
-		bodyDef.type = dynamic ? b2_dynamicBody : b2_staticBody;
-		body = world.CreateBody(&bodyDef);
+		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+	}
 
-		b2PolygonShape shape;
-		shape.SetAsBox(worldToBox2D(width / 2.0f), worldToBox2D(height / 2.0f));
+	void setDepthTest(bool enabled)
+	{
+		if (enabled) glEnable(GL_DEPTH_TEST); else glDisable(GL_DEPTH_TEST);
+	}
 
-		b2FixtureDef fixtureDef;
-		fixtureDef.density = 1.0f;
-		fixtureDef.shape = &shape;
+	void setDepthWrite(bool enabled)
+	{
+		glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+	}
 
-		body->CreateFixture(&fixtureDef);
+	void setBlending(bool enabled)
+	{
+		if (enabled)
+		{
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		}
+		else
+		{
+			glDisable(GL_BLEND);
+		}
+	}
 
-		body->SetTransform(body->GetPosition(), rotation);
+	void drawTriangles(int first, int count)
+	{
+		glDrawArrays(GL_TRIANGLES, first, count);
+		stats.drawCalls++;
+		stats.vertices += count;
+	}
 
-		numVertices = 6;
+private:
 
-		GLfloat vertices[] {
-			-width / 2.0f, height / 2.0f,
-			width / 2.0f, height / 2.0f,
-			-width / 2.0f, -height / 2.0f,
+	bool loadProgramBinaryFunctions()
+	{
+		if (getProgramBinaryOES && programBinaryOES) return true;
 
-			width / 2.0f, height / 2.0f,
-			width / 2.0f, -height / 2.0f,
-			-width / 2.0f, -height / 2.0f
-		};
+		const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+		if (!extensions || !strstr(extensions, "GL_OES_get_program_binary")) return false;
 
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
+		GLint formats = 0;
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &formats);
+		if (formats <= 0) return false;
 
-		glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+		getProgramBinaryOES = (PFNGLGETPROGRAMBINARYOESPROC)eglGetProcAddress("glGetProgramBinaryOES");
+		programBinaryOES = (PFNGLPROGRAMBINARYOESPROC)eglGetProcAddress("glProgramBinaryOES");
 
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return getProgramBinaryOES && programBinaryOES;
 	}
+
+	PFNGLGETPROGRAMBINARYOESPROC getProgramBinaryOES;
+	PFNGLPROGRAMBINARYOESPROC programBinaryOES;
 };
 
-std::vector<Shape*> shapes;
-int screenWidth = 0;
-int screenHeight = 0;
-int tWidth = 0;
-int tHeight = 0;
-std::random_device device;
-std::default_random_engine generator(device());
+GLES2Backend glesBackend;
+RenderBackend* backend = &glesBackend;
 
-void createShape()
-{
-	float w = randomFloat(tWidth / 5.0f, tWidth)(generator);
-	float h = randomFloat(tHeight / 5.0f, tHeight)(generator);
-	float x = randomFloat(tWidth / 8.0f + w, screenWidth - tWidth / 4.0f - w)(generator);
-	float y = randomFloat(tHeight / 8.0f + h, screenHeight - tHeight / 4.0f - h)(generator);
-	float r = randomFloat(0.0f, 1.0f)(generator);
-	float g = randomFloat(0.0f, 1.0f)(generator);
-	float b = randomFloat(0.0f, 1.0f)(generator);
-	float a = randomFloat(0.0f, 1.0f)(generator);
-	float angle = randomFloat(0.0f, 360.0f)(generator);
-
-	if(randomFloat(0.0f, 1.0f)(generator) > 0.49f)
-		shapes.push_back(new Triangle(x, y, w, h, glm::radians(angle), glm::vec4(r, g, b, a), world, true));
-	else
-		shapes.push_back(new Rectangle(x, y, w, h, glm::radians(angle), glm::vec4(r, g, b, a), world, true));
-}
+#pragma endregion
 
-void clearShapes()
+#endif
+
+#pragma region Recorder backend
+
+enum RenderCommandType
 {
-	for (auto shape : shapes)
-	{
-		delete shape;
-	}
+	CreateProgramCommand,
+	UseProgramCommand,
+	CreateBufferCommand,
+	DeleteBufferCommand,
+	BindBufferCommand,
+	BufferDataCommand,
+	BufferSubDataCommand,
+	EnableAttributeCommand,
+	DisableAttributeCommand,
+	AttributePointerCommand,
+	ConstantAttributeCommand,
+	UniformMatrixCommand,
+	ViewportCommand,
+	ClearColorCommand,
+	ClearCommand,
+	DepthTestCommand,
+	DepthWriteCommand,
+	BlendingCommand,
+	DrawTrianglesCommand,
+	RenderCommandCount
+};
 
-	shapes.clear();
-}
+struct RenderCommand
+{
+	RenderCommandType type;
+	unsigned int target;
+	size_t offset;
+	size_t size;
+};
 
-float createShapes(int width, int height)
+// Fragments a frame would shade, per viewport pixel.
+struct OverdrawStats
 {
-	tWidth = (width > height) ? height / 5.0f : width / 5.0f;
-	tHeight = tWidth;
+	double shaded;  // after depth rejection
+	double covered; // every fragment of every triangle
+	double pixels;
+};
 
-	// Borders
-	shapes.push_back(new Rectangle(width / 2.0f, tHeight / 8.0f, width, tHeight / 4.0f, glm::radians(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), world, false));
-	shapes.push_back(new Rectangle(width / 2.0f, height - tHeight / 8.0f, width, tHeight / 4.0f, glm::radians(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), world, false));
-	shapes.push_back(new Rectangle(tWidth / 8.0f, height / 2.0f, tWidth / 4.0f, height, glm::radians(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), world, false));
-	shapes.push_back(new Rectangle(width - tWidth / 8.0f, height / 2.0f, tWidth / 4.0f, height, glm::radians(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), world, false));
+// Headless backend. Records every call into a command list and keeps a CPU
+// copy of each buffer's contents, so a run can be inspected without a GPU.
+// With estimateOverdraw it also rasterizes draws at low resolution against
+// a depth grid to estimate how many fragments the GPU would shade.
+struct RecorderBackend : public RenderBackend
+{
+	RecorderBackend() : programBinaries(true), estimateOverdraw(false), nextHandle(1), boundBuffer(0), commandCounts(),
+		overdraw(), depthTest(false), depthWrite(true), viewportWidth(0), viewportHeight(0), matrix(1.0f), position() {}
 
-	//shapes.push_back(new Triangle(width / 1.5f, tHeight / 2.0f, tWidth / 1.5f, tHeight * 2.0f, glm::radians(44.5f), glm::vec4(0.0f, 0.6f, 0.1f, 1.0f), world, true));
-	//shapes.push_back(new Rectangle(0, height / 2.0f, tWidth * 4.0f, tHeight / 5.0f, glm::radians(15.0f), glm::vec4(0.0f, 0.4f, 0.2f, 1.0f), world, false));
+	void describe()
+	{
+		LOGI("Render backend = recorder\n");
+	}
 
-	//shapes.push_back(new Rectangle(width / 2.0f, tHeight, tWidth / 4.0f, tHeight, glm::radians(44.5f), glm::vec4(1.0f, 0.0f, 0.8f, 1.0f), world, true));
-	//shapes.push_back(new Rectangle(width / 3.0f, height / 2.0f, tWidth / 3.0f, tHeight / 3.0f, glm::radians(44.5f), glm::vec4(0.7f, 0.8f, 0.8f, 1.0f), world, true));
-}
+	std::string driverName()
+	{
+		return "AntRoit/recorder/1";
+	}
 
-#pragma endregion
+	unsigned int createProgram(const char* vertexSource, const char* fragmentSource)
+	{
+		unsigned int program = nextHandle++;
+		programSources.resize(program + 1);
+		programSources[program] = std::string(vertexSource) + '\0' + fragmentSource;
+		record(CreateProgramCommand, program, 0, programSources[program].size());
+		return program;
+	}
 
-#pragma region Init graphics
+	// The "binary" is the program's sources, so a round trip can be checked.
+	bool getProgramBinary(unsigned int program, std::vector<unsigned char>& binary, unsigned int& format)
+	{
+		if (!programBinaries || program >= programSources.size()) return false;
 
-void initGraphics(int width, int height)
-{
-	clearShapes();
+		binary.assign(programSources[program].begin(), programSources[program].end());
+		format = BinaryFormat;
+		return true;
+	}
 
-	screenWidth = width;
-	screenHeight = height;
+	unsigned int createProgramFromBinary(unsigned int format, const std::vector<unsigned char>& binary)
+	{
+		if (!programBinaries || format != BinaryFormat) return 0;
 
-	printGLString("Version", GL_VERSION);
-	printGLString("Vendor", GL_VENDOR);
-	printGLString("Renderer", GL_RENDERER);
-	printGLString("Extensions", GL_EXTENSIONS);
+		unsigned int program = nextHandle++;
+		programSources.resize(program + 1);
+		programSources[program].assign(binary.begin(), binary.end());
+		record(CreateProgramCommand, program, 0, 0);
+		return program;
+	}
 
-	LOGI("setupGraphics(%d, %d)", width, height);
+	int getUniformLocation(unsigned int program, const char* name)
+	{
+		return 0;
+	}
 
-	program = createProgram(vertexShader, fragmentShader);
-	if (!program)
+	void useProgram(unsigned int program)
 	{
-		LOGE("Could not create program.");
-		return;
+		record(UseProgramCommand, program, 0, 0);
 	}
 
-	glViewport(0, 0, width, height);
-	glClearColor(0.1f, 0.1f, 0.8f, 1.0f);
+	unsigned int createBuffer()
+	{
+		unsigned int buffer = nextHandle++;
+		if (buffers.size() <= buffer) buffers.resize(buffer + 1);
+		record(CreateBufferCommand, buffer, 0, 0);
+		return buffer;
+	}
 
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	void deleteBuffer(unsigned int buffer)
+	{
+		if (buffer < buffers.size()) std::vector<unsigned char>().swap(buffers[buffer]);
+		record(DeleteBufferCommand, buffer, 0, 0);
+	}
 
-	projection = glm::ortho(0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f);
+	void bindBuffer(unsigned int buffer)
+	{
+		boundBuffer = buffer;
+		record(BindBufferCommand, buffer, 0, 0);
+	}
 
-	createShapes(width, height);
-}
+	void bufferData(size_t size, const void* data, BufferUsage usage)
+	{
+		std::vector<unsigned char>& storage = buffers[boundBuffer];
+		storage.resize(size);
+		if (data)
+		{
+			memcpy(&storage[0], data, size);
+			stats.bytesUploaded += size;
+		}
+		record(BufferDataCommand, boundBuffer, 0, size);
+	}
 
-#pragma endregion
+	void bufferSubData(size_t offset, size_t size, const void* data)
+	{
+		memcpy(&buffers[boundBuffer][offset], data, size);
+		stats.bytesUploaded += size;
+		record(BufferSubDataCommand, boundBuffer, offset, size);
+	}
 
-#pragma region Update
+	void enableAttribute(unsigned int index)
+	{
+		record(EnableAttributeCommand, index, 0, 0);
+	}
 
-float currentTime = 0.0f;
-float accumulator = 0.0f;
-float step = 1.0f / 60.0f;
-float spawnTime = 0.0f;
-float backgroundFun = 0.0f;
-float clearR = 0.2f;
-float clearG = 0.3f;
-float clearB = 0.5f;
+	void disableAttribute(unsigned int index)
+	{
+		record(DisableAttributeCommand, index, 0, 0);
+	}
 
-void update(int time)
-{
-	float newTime = time / 1000.0f;
+	void attributePointer(unsigned int index, int size, AttributeType type, bool normalized, int stride, size_t offset)
+	{
+		if (index == PositionAttribute)
+		{
+			AttributeLayout layout = { boundBuffer, size, type, stride, offset };
+			position = layout;
+		}
 
-	float deltaTime = std::min(newTime - currentTime, 0.25f);
-	currentTime = newTime;
+		record(AttributePointerCommand, index, offset, stride);
+	}
 
-	accumulator += deltaTime;
+	void constantAttribute(unsigned int index, const float* value)
+	{
+		stats.bytesUploaded += 4 * sizeof(float);
+		record(ConstantAttributeCommand, index, 0, 4 * sizeof(float));
+	}
 
-	while (accumulator >= step)
+	void uniformMatrix(int location, const float* value)
 	{
-		clearR += randomFloat(-0.01f, 0.01f)(generator);
-		clearG += randomFloat(-0.01f, 0.01f)(generator);
-		clearB += randomFloat(-0.01f, 0.01f)(generator);
+		matrix = glm::make_mat4(value);
+		stats.bytesUploaded += 16 * sizeof(float);
+		record(UniformMatrixCommand, location, 0, 16 * sizeof(float));
+	}
 
-		if (clearR > 1.0f) clearR = 1.0f; else if (clearR < 0.0f) clearR = 0.0f;
-		if (clearG > 1.0f) clearG = 1.0f; else if (clearG < 0.0f) clearG = 0.0f;
-		if (clearB > 1.0f) clearB = 1.0f; else if (clearB < 0.0f) clearB = 0.0f;
+	void viewport(int x, int y, int width, int height)
+	{
+		viewportWidth = width;
+		viewportHeight = height;
+		record(ViewportCommand, 0, width, height);
+	}
 
-		glClearColor(clearR, clearG, clearB, 1.0f);
+	void clearColor(float r, float g, float b, float a)
+	{
+		record(ClearColorCommand, 0, 0, 0);
+	}
 
-		world.Step(step, 8, 3);
+	void clear()
+	{
+		if (estimateOverdraw)
+		{
+			depth.assign(gridWidth() * gridHeight(), 1.0f);
+			overdraw.pixels += (double)viewportWidth * viewportHeight;
+		}
 
-		accumulator -= step;
+		record(ClearCommand, 0, 0, 0);
+	}
 
-		if (newTime - spawnTime > 2.0f)
-		{
-			createShape();
+	void setDepthTest(bool enabled)
+	{
+		depthTest = enabled;
+		record(DepthTestCommand, enabled, 0, 0);
+	}
 
-			spawnTime = newTime;
-		}
+	void setDepthWrite(bool enabled)
+	{
+		depthWrite = enabled;
+		record(DepthWriteCommand, enabled, 0, 0);
 	}
-}
 
-#pragma endregion
+	void setBlending(bool enabled)
+	{
+		record(BlendingCommand, enabled, 0, 0);
+	}
 
-#pragma region Touch
+	void drawTriangles(int first, int count)
+	{
+		stats.drawCalls++;
+		stats.vertices += count;
+		record(DrawTrianglesCommand, boundBuffer, first, count);
 
-void touch(float x, float y)
-{
-	LOGI("PLS NO TOUCH :D %f, %f\n", x, y);
+		if (estimateOverdraw) rasterize(first, count);
+	}
 
-	// Sori remes yritin mutta en osannu :(
-	//float w = randomFloat(tWidth / 5.0f, tWidth)(generator);
-	//float h = randomFloat(tHeight / 5.0f, tHeight)(generator);
+	// Drops the recorded commands but keeps buffer contents, like a frame
+	// boundary would.
+	void reset()
+	{
+		commands.clear();
+		memset(commandCounts, 0, sizeof(commandCounts));
+		overdraw = OverdrawStats();
+	}
 
-	//if (x > tWidth / 8.0f + w && x < screenWidth - tWidth / 4.0f - w &&
-	//	y > tHeight / 8.0f + h && y < screenHeight - tHeight / 4.0f - h)
-	//{
-	//	float r = randomFloat(0.0f, 1.0f)(generator);
-	//	float g = randomFloat(0.0f, 1.0f)(generator);
-	//	float b = randomFloat(0.0f, 1.0f)(generator);
-	//	float a = randomFloat(0.0f, 1.0f)(generator);
-	//	float angle = randomFloat(0.0f, 360.0f)(generator);
+	// Turn off to act like a driver without GL_OES_get_program_binary.
+	bool programBinaries;
+	bool estimateOverdraw;
 
-	//	if (randomFloat(0.0f, 1.0f)(generator) > 0.49f)
-	//		shapes.push_back(new Triangle(x, y, w, h, glm::radians(angle), glm::vec4(r, g, b, a), world, true));
-	//	else
-	//		shapes.push_back(new Rectangle(x, y, w, h, glm::radians(angle), glm::vec4(r, g, b, a), world, true));
-	//}
-}
+	std::vector<RenderCommand> commands;
+	std::vector<std::vector<unsigned char> > buffers;
+	std::vector<std::string> programSources;
+	unsigned int nextHandle;
+	unsigned int boundBuffer;
+	unsigned int commandCounts[RenderCommandCount];
 
-#pragma endregion
+	// Since the last reset().
+	OverdrawStats overdraw;
 
-#pragma region Draw
+private:
 
-void draw()
-{
-	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+	static const unsigned int BinaryFormat = 0x52454321;
 
-	glUseProgram(program);
+	// Overdraw grid cells are this many pixels on a side.
+	static const int CellSize = 4;
 
-	for (auto shape : shapes)
+	struct AttributeLayout
 	{
-		shape->draw();
+		unsigned int buffer;
+		int size;
+		AttributeType type;
+		int stride;
+		size_t offset;
+	};
+
+	int gridWidth() const
+	{
+		return (viewportWidth + CellSize - 1) / CellSize;
 	}
 
-	glUseProgram(0);
-}
-
-#pragma endregion
-
-#pragma region Java
-
-extern "C"
-{
-	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_init(JNIEnv* env, jobject obj, jint width, jint height)
+	int gridHeight() const
 	{
-		initGraphics(width, height);
+		return (viewportHeight + CellSize - 1) / CellSize;
 	}
 
-	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_step(JNIEnv* env, jobject obj, jlong time)
+	// Reads a position from the CPU copy and returns it in grid cells, with
+	// window depth in z.
+	glm::vec3 project(int vertex) const
 	{
-		update(time);
+		const unsigned char* data = &buffers[position.buffer][position.offset + vertex * position.stride];
+
+		glm::vec4 v(0.0f, 0.0f, 0.0f, 1.0f);
+		for (int i = 0; i < position.size; i++)
+		{
+			if (position.type == ShortAttribute) v[i] = ((const short*)data)[i];
+			else if (position.type == UnsignedByteAttribute) v[i] = data[i];
+			else v[i] = ((const float*)data)[i];
+		}
+
+		glm::vec4 clip = matrix * v;
+		glm::vec3 ndc = glm::vec3(clip) / clip.w;
+
+		return glm::vec3((ndc.x + 1.0f) * 0.5f * viewportWidth / CellSize,
+			(ndc.y + 1.0f) * 0.5f * viewportHeight / CellSize,
+			(ndc.z + 1.0f) * 0.5f);
+	}
+
+	// Samples each triangle at cell centers against the depth grid, with
+	// GL_LESS as the depth function.
+	void rasterize(int first, int count)
+	{
+		int width = gridWidth();
+		int height = gridHeight();
+		if (depth.size() != (size_t)(width * height)) depth.assign(width * height, 1.0f);
+
+		double cellArea = CellSize * CellSize;
+
+		for (int t = first; t + 2 < first + count; t += 3)
+		{
+			glm::vec3 a = project(t);
+			glm::vec3 b = project(t + 1);
+			glm::vec3 c = project(t + 2);
+
+			float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+			if (area == 0.0f) continue;
+
+			int minX = std::max((int)floorf(std::min(a.x, std::min(b.x, c.x))), 0);
+			int maxX = std::min((int)ceilf(std::max(a.x, std::max(b.x, c.x))), width - 1);
+			int minY = std::max((int)floorf(std::min(a.y, std::min(b.y, c.y))), 0);
+			int maxY = std::min((int)ceilf(std::max(a.y, std::max(b.y, c.y))), height - 1);
+
+			for (int y = minY; y <= maxY; y++)
+			{
+				for (int x = minX; x <= maxX; x++)
+				{
+					float px = x + 0.5f;
+					float py = y + 0.5f;
+
+					float wa = ((b.x - px) * (c.y - py) - (b.y - py) * (c.x - px)) / area;
+					float wb = ((c.x - px) * (a.y - py) - (c.y - py) * (a.x - px)) / area;
+					float wc = 1.0f - wa - wb;
+					if (wa < 0.0f || wb < 0.0f || wc < 0.0f) continue;
+
+					overdraw.covered += cellArea;
+
+					float z = wa * a.z + wb * b.z + wc * c.z;
+					float& stored = depth[y * width + x];
+
+					if (depthTest && !(z < stored)) continue;
+
+					overdraw.shaded += cellArea;
+					if (depthTest && depthWrite) stored = z;
+				}
+			}
+		}
+	}
+
+	bool depthTest;
+	bool depthWrite;
+	int viewportWidth;
+	int viewportHeight;
+	glm::mat4 matrix;
+	AttributeLayout position;
+	std::vector<float> depth;
+
+	void record(RenderCommandType type, unsigned int target, size_t offset, size_t size)
+	{
+		RenderCommand command = { type, target, offset, size };
+		commands.push_back(command);
+		commandCounts[type]++;
+	}
+};
+
+#ifdef ANTROIT_HEADLESS
+RecorderBackend recorder;
+RenderBackend* backend = &recorder;
+#endif
+
+#pragma endregion
+
+#pragma region Geometry cache
+
+enum ShapeType
+{
+	TriangleShape,
+	RectangleShape
+};
+
+struct Geometry
+{
+	ShapeType type;
+	unsigned int first;
+	unsigned int count;
+};
+
+// Unit meshes shared by every shape of the same type and outline. A shape
+// stores only a geometry id and its size; the batch scales the shared mesh
+// per instance, so spawning does no vertex or GL work at all.
+//
+// Meshes are added before the simulation starts and only read afterwards,
+// so both threads may use the cache without locking.
+struct GeometryCache
+{
+	// Returns the id of an identical mesh if one is cached, else adds it.
+	unsigned int intern(ShapeType type, const glm::vec2* data, unsigned int count)
+	{
+		for (unsigned int id = 0; id < meshes.size(); id++)
+		{
+			const Geometry& mesh = meshes[id];
+			if (mesh.type == type && mesh.count == count &&
+				!memcmp(&vertices[mesh.first], data, count * sizeof(glm::vec2)))
+			{
+				return id;
+			}
+		}
+
+		Geometry mesh = { type, (unsigned int)vertices.size(), count };
+		vertices.insert(vertices.end(), data, data + count);
+		meshes.push_back(mesh);
+
+		return meshes.size() - 1;
+	}
+
+	const Geometry& operator[](unsigned int id) const
+	{
+		return meshes[id];
+	}
+
+	std::vector<glm::vec2> vertices;
+	std::vector<Geometry> meshes;
+};
+
+GeometryCache geometryCache;
+
+static const glm::vec2 triangleVertices[] = {
+	glm::vec2(-0.5f, 0.5f), glm::vec2(0.5f, 0.5f), glm::vec2(-0.5f, -0.5f)
+};
+
+static const glm::vec2 rectangleVertices[] = {
+	glm::vec2(-0.5f, 0.5f), glm::vec2(0.5f, 0.5f), glm::vec2(-0.5f, -0.5f),
+	glm::vec2(0.5f, 0.5f), glm::vec2(0.5f, -0.5f), glm::vec2(-0.5f, -0.5f)
+};
+
+const unsigned int TriangleGeometry = geometryCache.intern(TriangleShape, triangleVertices, 3);
+const unsigned int RectangleGeometry = geometryCache.intern(RectangleShape, rectangleVertices, 6);
+
+#pragma endregion
+
+#pragma region Snapshot
+
+// What one update() did, carried to the renderer with its snapshot.
+struct UpdateStats
+{
+	float milliseconds;
+	int substeps;
+	int level;
+	b2Profile profile; // summed over the substeps
+	unsigned int bodies;
+	unsigned int contacts;
+	unsigned int proxies;
+	unsigned int inputEvents;
+};
+
+struct BodySnapshot
+{
+	glm::vec2 previousPosition;
+	glm::vec2 position;
+	float previousAngle;
+	float angle;
+	unsigned int geometry;
+	glm::vec2 size;
+	glm::vec4 color;
+};
+
+// Everything the renderer needs from one simulation step. The simulation
+// writes these and the renderer only ever reads a published one.
+struct Snapshot
+{
+	std::vector<BodySnapshot> bodies;
+	glm::vec3 clearColor;
+
+	// Leftover accumulator as a fraction of step when this was published,
+	// at the given update() time in nanoseconds.
+	float alpha;
+	float step;
+	long long time;
+
+	// Shapes left out by view culling.
+	unsigned int culled;
+
+	UpdateStats update;
+
+	// Steady clock nanoseconds of the oldest input this snapshot is the
+	// first to show; 0 if none.
+	long long inputTime;
+};
+
+// Lock-free handoff of the latest value from one producer to one consumer.
+// Each side owns one slot; publish and consume swap their slot with the
+// shared middle one, so neither side ever waits and the consumer always
+// sees the newest complete value.
+template <typename T>
+struct TripleBuffer
+{
+	TripleBuffer() : writeIndex(0), middle(1), readIndex(2) {}
+
+	T& writeBuffer()
+	{
+		return buffers[writeIndex];
+	}
+
+	void publish()
+	{
+		writeIndex = middle.exchange(writeIndex | FreshBit, std::memory_order_acq_rel) & IndexMask;
+	}
+
+	// Returns false, keeping the previous value, if nothing new was published.
+	bool consume()
+	{
+		if (!(middle.load(std::memory_order_acquire) & FreshBit)) return false;
+		readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & IndexMask;
+		return true;
+	}
+
+	const T& readBuffer() const
+	{
+		return buffers[readIndex];
+	}
+
+private:
+
+	static const unsigned int FreshBit = 4;
+	static const unsigned int IndexMask = 3;
+
+	T buffers[3];
+	unsigned int writeIndex;
+	std::atomic<unsigned int> middle;
+	unsigned int readIndex;
+};
+
+TripleBuffer<Snapshot> snapshots;
+
+#pragma endregion
+
+#pragma region Batch
+
+// 12 bytes: position in 1/PositionScale pixels from the batch origin, the
+// shape's layer as depth, and RGBA8 color, against 24 bytes for float
+// position and color. The padding keeps the stride and the color 4-byte
+// aligned, which mobile drivers otherwise repack on the CPU at upload.
+struct BatchVertex
+{
+	short x, y, z;
+	short padding;
+	unsigned int color;
+};
+
+// Quarter pixel steps leave room for 8191 pixels either side of the view
+// origin, more than culling lets through on any screen.
+static const float PositionScale = 4.0f;
+
+// Shapes at least this opaque skip blending; 250 of 255 is invisible.
+static const float OpaqueAlpha = 250.0f / 255.0f;
+
+short toFixed(float value)
+{
+	return (short)glm::clamp((int)floorf(value * PositionScale + 0.5f), -32768, 32767);
+}
+
+enum RenderPass
+{
+	OpaquePass,
+	TranslucentPass,
+	RenderPassCount
+};
+
+// Collects every shape's transformed vertices for the frame and submits
+// them from one orphaned stream buffer. Opaque shapes go first, front to
+// back with depth writes and no blending, so the depth test rejects what
+// they hide; translucent shapes follow back to front, blended and depth
+// tested but not written.
+struct Batch
+{
+	Batch() : VBO(0), capacity(0), origin(0.0f) {}
+
+	void init()
+	{
+		VBO = backend->createBuffer();
+		capacity = 0;
+		for (auto& pass : passes) pass.clear();
+	}
+
+	// Positions are stored relative to origin, normally the view corner.
+	void begin(const glm::vec2& viewOrigin)
+	{
+		for (auto& pass : passes) pass.clear();
+		origin = viewOrigin;
+	}
+
+	static bool isOpaque(const BodySnapshot& body)
+	{
+		return body.color.a >= OpaqueAlpha;
+	}
+
+	// Depth for the shape at rank among count shapes ordered back to
+	// front; higher ranks are nearer.
+	static short layerDepth(unsigned int rank, unsigned int count)
+	{
+		return (short)(((rank + 1) * 2.0f / (count + 1) - 1.0f) * 32767.0f);
+	}
+
+	// Blends the body's last two physics states by alpha.
+	void add(const BodySnapshot& body, float alpha, short depth, RenderPass pass)
+	{
+		const Geometry& mesh = geometryCache[body.geometry];
+		const glm::vec2* local = &geometryCache.vertices[mesh.first];
+		unsigned int count = mesh.count;
+
+		glm::vec2 position = glm::mix(body.previousPosition, body.position, alpha) - origin;
+		float angle = glm::mix(body.previousAngle, body.angle, alpha);
+
+		float c = cosf(angle);
+		float s = sinf(angle);
+
+		unsigned int color = glm::packUnorm4x8(body.color);
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			glm::vec2 v = local[i] * body.size;
+
+			BatchVertex vertex;
+			vertex.x = toFixed(position.x + c * v.x - s * v.y);
+			vertex.y = toFixed(position.y + s * v.x + c * v.y);
+			vertex.z = depth;
+			vertex.padding = 0;
+			vertex.color = color;
+			passes[pass].push_back(vertex);
+		}
+	}
+
+	void flush()
+	{
+		size_t opaque = passes[OpaquePass].size();
+		size_t translucent = passes[TranslucentPass].size();
+		if (opaque + translucent == 0) return;
+
+		size_t size = (opaque + translucent) * sizeof(BatchVertex);
+
+		backend->bindBuffer(VBO);
+
+		while (capacity < size) capacity = capacity ? capacity * 2 : 64 * 1024;
+
+		// Orphan the previous storage so the driver never stalls on a buffer
+		// the GPU is still reading from last frame.
+		backend->bufferData(capacity, NULL, StreamDraw);
+		if (opaque) backend->bufferSubData(0, opaque * sizeof(BatchVertex), &passes[OpaquePass][0]);
+		if (translucent) backend->bufferSubData(opaque * sizeof(BatchVertex), translucent * sizeof(BatchVertex), &passes[TranslucentPass][0]);
+
+		backend->enableAttribute(PositionAttribute);
+		backend->enableAttribute(ColorAttribute);
+
+		backend->attributePointer(PositionAttribute, 3, ShortAttribute, false, sizeof(BatchVertex), offsetof(BatchVertex, x));
+		backend->attributePointer(ColorAttribute, 4, UnsignedByteAttribute, true, sizeof(BatchVertex), offsetof(BatchVertex, color));
+
+		glm::mat4 mvp = projection * glm::translate(glm::mat4(1.0f), glm::vec3(origin, 0.0f)) *
+			glm::scale(glm::mat4(1.0f), glm::vec3(1.0f / PositionScale, 1.0f / PositionScale, 1.0f / 32767.0f));
+		backend->uniformMatrix(mvpLocation, glm::value_ptr(mvp));
+
+		if (opaque)
+		{
+			backend->setBlending(false);
+			backend->setDepthWrite(true);
+			backend->drawTriangles(0, opaque);
+		}
+
+		if (translucent)
+		{
+			backend->setBlending(true);
+			backend->setDepthWrite(false);
+			backend->drawTriangles(opaque, translucent);
+
+			// glClear only clears depth while writes are on.
+			backend->setDepthWrite(true);
+		}
+
+		backend->disableAttribute(ColorAttribute);
+		backend->disableAttribute(PositionAttribute);
+
+		backend->bindBuffer(0);
+	}
+
+	std::vector<BatchVertex> passes[RenderPassCount];
+	unsigned int VBO;
+	size_t capacity;
+	glm::vec2 origin;
+};
+
+Batch batch;
+
+#pragma endregion
+
+#pragma region Scene
+
+struct ShapeHandle
+{
+	unsigned int slot;
+	unsigned int generation;
+};
+
+// Structure-of-arrays store for every shape in the world. Entry i of each
+// dense array describes the same shape; removal swaps the last entry into
+// the hole so the arrays stay packed. Handles go through a slot table and
+// stay valid until their own shape is removed. Each body's user data holds
+// its slot. Owned by the simulation; nothing here touches GL.
+struct Scene
+{
+	Scene() : nextSequence(0) {}
+
+	ShapeHandle add(b2Body* body, unsigned int geometry, const glm::vec2& size, const glm::vec4& color, float spawnTime)
+	{
+		unsigned int slot;
+		if (!freeSlots.empty())
+		{
+			slot = freeSlots.back();
+			freeSlots.pop_back();
+		}
+		else
+		{
+			slot = denseOf.size();
+			denseOf.push_back(0);
+			generations.push_back(0);
+		}
+
+		denseOf[slot] = bodies.size();
+
+		bodies.push_back(body);
+		geometries.push_back(geometry);
+		sizes.push_back(size);
+		colors.push_back(color);
+		previousPositions.push_back(body->GetPosition());
+		previousAngles.push_back(body->GetAngle());
+		spawnTimes.push_back(spawnTime);
+		sequences.push_back(nextSequence++);
+		asleepSince.push_back(-1.0f);
+		slots.push_back(slot);
+
+		body->SetUserData((void*)(size_t)slot);
+
+		ShapeHandle handle = { slot, generations[slot] };
+		return handle;
+	}
+
+	bool valid(ShapeHandle handle) const
+	{
+		return handle.slot < generations.size() && generations[handle.slot] == handle.generation;
+	}
+
+	unsigned int indexOf(ShapeHandle handle) const
+	{
+		return denseOf[handle.slot];
+	}
+
+	unsigned int indexOfSlot(unsigned int slot) const
+	{
+		return denseOf[slot];
+	}
+
+	ShapeHandle handleAt(unsigned int index) const
+	{
+		ShapeHandle handle = { slots[index], generations[slots[index]] };
+		return handle;
+	}
+
+	// Forgets the shape. The caller owns destroying its body.
+	void remove(ShapeHandle handle)
+	{
+		if (!valid(handle)) return;
+
+		unsigned int index = denseOf[handle.slot];
+		unsigned int last = bodies.size() - 1;
+
+		if (index != last)
+		{
+			bodies[index] = bodies[last];
+			geometries[index] = geometries[last];
+			sizes[index] = sizes[last];
+			colors[index] = colors[last];
+			previousPositions[index] = previousPositions[last];
+			previousAngles[index] = previousAngles[last];
+			spawnTimes[index] = spawnTimes[last];
+			sequences[index] = sequences[last];
+			asleepSince[index] = asleepSince[last];
+			slots[index] = slots[last];
+			denseOf[slots[index]] = index;
+		}
+
+		bodies.pop_back();
+		geometries.pop_back();
+		sizes.pop_back();
+		colors.pop_back();
+		previousPositions.pop_back();
+		previousAngles.pop_back();
+		spawnTimes.pop_back();
+		sequences.pop_back();
+		asleepSince.pop_back();
+		slots.pop_back();
+
+		generations[handle.slot]++;
+		freeSlots.push_back(handle.slot);
+	}
+
+	void clear()
+	{
+		for (size_t i = 0; i < slots.size(); i++)
+		{
+			generations[slots[i]]++;
+			freeSlots.push_back(slots[i]);
+		}
+
+		bodies.clear();
+		geometries.clear();
+		sizes.clear();
+		colors.clear();
+		previousPositions.clear();
+		previousAngles.clear();
+		spawnTimes.clear();
+		sequences.clear();
+		asleepSince.clear();
+		slots.clear();
+	}
+
+	size_t size() const
+	{
+		return bodies.size();
+	}
+
+	// Called before every world step so the renderer can interpolate from
+	// where each body was to where it is.
+	void savePrevious()
+	{
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			previousPositions[i] = bodies[i]->GetPosition();
+			previousAngles[i] = bodies[i]->GetAngle();
+		}
+	}
+
+	// Remembers when each body fell asleep, for the sleeping-longest
+	// retirement policy.
+	// Returns how many dynamic bodies are still awake.
+	unsigned int updateSleep(float time)
+	{
+		unsigned int awake = 0;
+
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			if (bodies[i]->IsAwake())
+			{
+				asleepSince[i] = -1.0f;
+				if (bodies[i]->GetType() == b2_dynamicBody) awake++;
+			}
+			else if (asleepSince[i] < 0.0f)
+			{
+				asleepSince[i] = time;
+			}
+		}
+
+		return awake;
+	}
+
+	void snapshot(std::vector<BodySnapshot>& out) const
+	{
+		out.resize(bodies.size());
+
+		for (size_t i = 0; i < bodies.size(); i++)
+		{
+			write(i, out[i]);
+		}
+	}
+
+	// Snapshots only the given entries, in the given order.
+	void snapshot(const std::vector<unsigned int>& indices, std::vector<BodySnapshot>& out) const
+	{
+		out.resize(indices.size());
+
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			write(indices[i], out[i]);
+		}
+	}
+
+	void write(unsigned int i, BodySnapshot& body) const
+	{
+		body.previousPosition = box2DToWorld(previousPositions[i]);
+		body.position = box2DToWorld(bodies[i]->GetPosition());
+		body.previousAngle = previousAngles[i];
+		body.angle = bodies[i]->GetAngle();
+		body.geometry = geometries[i];
+		body.size = sizes[i];
+		body.color = colors[i];
+	}
+
+	std::vector<b2Body*> bodies;
+	std::vector<unsigned int> geometries;
+	std::vector<glm::vec2> sizes;
+	std::vector<glm::vec4> colors;
+	std::vector<b2Vec2> previousPositions;
+	std::vector<float> previousAngles;
+	std::vector<float> spawnTimes;
+	std::vector<unsigned int> sequences; // add() order; later shapes draw on top
+	std::vector<float> asleepSince;
+	std::vector<unsigned int> slots;
+
+private:
+
+	std::vector<unsigned int> denseOf;
+	std::vector<unsigned int> generations;
+	std::vector<unsigned int> freeSlots;
+	unsigned int nextSequence;
+};
+
+Scene scene;
+
+#pragma endregion
+
+#pragma region Body pool
+
+// Retired dynamic bodies, kept deactivated with their fixture so spawning a
+// shape of the same type reuses them instead of allocating a new body.
+struct BodyPool
+{
+	b2Body* acquire(ShapeType type)
+	{
+		std::vector<b2Body*>& pool = bodies[type];
+		if (pool.empty()) return nullptr;
+
+		b2Body* body = pool.back();
+		pool.pop_back();
+		return body;
+	}
+
+	void release(ShapeType type, b2Body* body)
+	{
+		body->SetActive(false);
+		bodies[type].push_back(body);
+	}
+
+	void clear()
+	{
+		for (int type = 0; type < 2; type++)
+		{
+			for (auto body : bodies[type])
+			{
+				world.DestroyBody(body);
+			}
+
+			bodies[type].clear();
+		}
+	}
+
+	size_t size() const
+	{
+		return bodies[TriangleShape].size() + bodies[RectangleShape].size();
+	}
+
+	std::vector<b2Body*> bodies[2];
+};
+
+BodyPool bodyPool;
+
+#pragma endregion
+
+#pragma region Shapes
+
+b2Body* createBody(ShapeType type, float x, float y, float rotation, const b2PolygonShape& shape, float friction, bool dynamic)
+{
+	b2Body* body = dynamic ? bodyPool.acquire(type) : nullptr;
+
+	if (body)
+	{
+		// Inactive bodies have no proxies, so the fixture's shape can be
+		// swapped in place; reactivating rebuilds the proxies from it.
+		*static_cast<b2PolygonShape*>(body->GetFixtureList()->GetShape()) = shape;
+
+		body->SetTransform(worldToBox2D(x, y), rotation);
+		body->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
+		body->SetAngularVelocity(0.0f);
+		body->SetActive(true);
+		body->ResetMassData();
+		body->SetAwake(true);
+
+		return body;
+	}
+
+	b2BodyDef bodyDef;
+	bodyDef.position = worldToBox2D(x, y);
+	bodyDef.angle = rotation;
+	bodyDef.type = dynamic ? b2_dynamicBody : b2_staticBody;
+	body = world.CreateBody(&bodyDef);
+
+	b2FixtureDef fixtureDef;
+	fixtureDef.friction = friction;
+	fixtureDef.density = 1.0f;
+	fixtureDef.shape = &shape;
+
+	body->CreateFixture(&fixtureDef);
+
+	return body;
+}
+
+ShapeHandle createTriangle(float x, float y, float width, float height, float rotation, const glm::vec4& color, bool dynamic)
+{
+	b2PolygonShape shape;
+	b2Vec2 shapetices[3];
+
+	shapetices[0].Set(-worldToBox2D(width / 2.0f), worldToBox2D(height / 2.0f));
+	shapetices[1].Set(worldToBox2D(width / 2.0f), worldToBox2D(height / 2.0f));
+	shapetices[2].Set(-worldToBox2D(width / 2.0f), -worldToBox2D(height / 2.0f));
+
+	shape.Set(shapetices, 3);
+
+	b2Body* body = createBody(TriangleShape, x, y, rotation, shape, 1.0f, dynamic);
+
+	return scene.add(body, TriangleGeometry, glm::vec2(width, height), color, currentTime);
+}
+
+ShapeHandle createRectangle(float x, float y, float width, float height, float rotation, const glm::vec4& color, bool dynamic)
+{
+	b2PolygonShape shape;
+	shape.SetAsBox(worldToBox2D(width / 2.0f), worldToBox2D(height / 2.0f));
+
+	b2Body* body = createBody(RectangleShape, x, y, rotation, shape, b2FixtureDef().friction, dynamic);
+
+	return scene.add(body, RectangleGeometry, glm::vec2(width, height), color, currentTime);
+}
+
+// Joint pulling the body under the finger, if any.
+b2MouseJoint* dragJoint = nullptr;
+
+void releaseDrag()
+{
+	if (!dragJoint) return;
+
+	world.DestroyJoint(dragJoint);
+	dragJoint = nullptr;
+}
+
+void destroyShape(ShapeHandle handle)
+{
+	if (!scene.valid(handle)) return;
+
+	b2Body* body = scene.bodies[scene.indexOf(handle)];
+	if (dragJoint && dragJoint->GetBodyB() == body) releaseDrag();
+
+	world.DestroyBody(body);
+	scene.remove(handle);
+}
+
+// Takes the shape out of the world and parks its body for reuse.
+void retireShape(ShapeHandle handle)
+{
+	if (!scene.valid(handle)) return;
+
+	unsigned int index = scene.indexOf(handle);
+
+	// A parked body must not come back with the joint still attached.
+	if (dragJoint && dragJoint->GetBodyB() == scene.bodies[index]) releaseDrag();
+
+	bodyPool.release(geometryCache[scene.geometries[index]].type, scene.bodies[index]);
+	scene.remove(handle);
+}
+
+int screenWidth = 0;
+int screenHeight = 0;
+int tWidth = 0;
+int tHeight = 0;
+// Spawned shape size in pixels; 0 derives it from the screen. Large worlds
+// need shapes smaller than the default fifth of the screen.
+int shapeSize = 0;
+std::random_device device;
+unsigned int seed = device();
+std::mt19937 generator(seed);
+
+enum RetirementPolicy
+{
+	RetireOldest,
+	RetireSleepingLongest,
+	RetireOffScreen
+};
+
+// Upper bound on spawned (dynamic) shapes; 0 means unbounded. Once reached,
+// each spawn first retires one shape picked by the policy.
+int populationCap = 256;
+RetirementPolicy retirementPolicy = RetireOldest;
+
+bool isOffScreen(unsigned int index)
+{
+	glm::vec2 position = box2DToWorld(scene.bodies[index]->GetPosition());
+	float margin = std::max(scene.sizes[index].x, scene.sizes[index].y);
+
+	return position.x < camera.x - margin || position.y < camera.y - margin ||
+		position.x > camera.x + screenWidth + margin || position.y > camera.y + screenHeight + margin;
+}
+
+// Picks the shape to retire under the current policy. Falls back to the
+// oldest when nothing is asleep or off screen. Returns -1 if no dynamic
+// shape exists.
+int chooseRetiree()
+{
+	int oldest = -1;
+	int chosen = -1;
+
+	for (unsigned int i = 0; i < scene.size(); i++)
+	{
+		if (scene.bodies[i]->GetType() != b2_dynamicBody) continue;
+
+		if (oldest < 0 || scene.spawnTimes[i] < scene.spawnTimes[oldest]) oldest = i;
+
+		if (retirementPolicy == RetireSleepingLongest && scene.asleepSince[i] >= 0.0f)
+		{
+			if (chosen < 0 || scene.asleepSince[i] < scene.asleepSince[chosen]) chosen = i;
+		}
+		else if (retirementPolicy == RetireOffScreen && isOffScreen(i))
+		{
+			if (chosen < 0 || scene.spawnTimes[i] < scene.spawnTimes[chosen]) chosen = i;
+		}
+	}
+
+	return chosen >= 0 ? chosen : oldest;
+}
+
+unsigned int dynamicCount()
+{
+	unsigned int count = 0;
+	for (auto body : scene.bodies)
+	{
+		if (body->GetType() == b2_dynamicBody) count++;
+	}
+	return count;
+}
+
+void createShape()
+{
+	if (populationCap > 0 && dynamicCount() >= (unsigned int)populationCap)
+	{
+		int retiree = chooseRetiree();
+		if (retiree >= 0) retireShape(scene.handleAt(retiree));
+	}
+
+	float w = RandomFloat(tWidth / 5.0f, tWidth)(generator);
+	float h = RandomFloat(tHeight / 5.0f, tHeight)(generator);
+	float x = RandomFloat(tWidth / 8.0f + w, screenWidth - tWidth / 4.0f - w)(generator);
+	float y = RandomFloat(tHeight / 8.0f + h, screenHeight - tHeight / 4.0f - h)(generator);
+	float r = RandomFloat(0.0f, 1.0f)(generator);
+	float g = RandomFloat(0.0f, 1.0f)(generator);
+	float b = RandomFloat(0.0f, 1.0f)(generator);
+	float a = RandomFloat(0.0f, 1.0f)(generator);
+	float angle = RandomFloat(0.0f, 360.0f)(generator);
+
+	if(RandomFloat(0.0f, 1.0f)(generator) > 0.49f)
+		createTriangle(x, y, w, h, glm::radians(angle), glm::vec4(r, g, b, a), true);
+	else
+		createRectangle(x, y, w, h, glm::radians(angle), glm::vec4(r, g, b, a), true);
+}
+
+void clearShapes()
+{
+	releaseDrag();
+
+	for (auto body : scene.bodies)
+	{
+		world.DestroyBody(body);
+	}
+
+	scene.clear();
+	bodyPool.clear();
+}
+
+ShapeHandle borders[4];
+
+void createBorders(int width, int height)
+{
+	for (auto& border : borders)
+	{
+		destroyShape(border);
+	}
+
+	tWidth = (width > height) ? height / 5.0f : width / 5.0f;
+	tHeight = tWidth;
+
+	borders[0] = createRectangle(width / 2.0f, tHeight / 8.0f, width, tHeight / 4.0f, glm::radians(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), false);
+	borders[1] = createRectangle(width / 2.0f, height - tHeight / 8.0f, width, tHeight / 4.0f, glm::radians(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), false);
+	borders[2] = createRectangle(tWidth / 8.0f, height / 2.0f, tWidth / 4.0f, height, glm::radians(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), false);
+	borders[3] = createRectangle(width - tWidth / 8.0f, height / 2.0f, tWidth / 4.0f, height, glm::radians(0.0f), glm::vec4(1.0f, 0.0f, 0.0f, 1.0f), false);
+
+	if (shapeSize > 0) tWidth = tHeight = shapeSize;
+}
+
+// Fits the running scene to a new surface size: the borders follow the
+// screen edges and bodies left outside them are pulled back in.
+void resizeShapes(int width, int height)
+{
+	createBorders(width, height);
+
+	float margin = tWidth / 4.0f;
+	b2Vec2 lower(worldToBox2D(margin), worldToBox2D(margin));
+	b2Vec2 upper(worldToBox2D(width - margin), worldToBox2D(height - margin));
+
+	for (auto body : scene.bodies)
+	{
+		if (body->GetType() != b2_dynamicBody) continue;
+
+		b2Vec2 position = body->GetPosition();
+		b2Vec2 clamped = b2Clamp(position, lower, upper);
+
+		if (!(clamped == position))
+		{
+			body->SetTransform(clamped, body->GetAngle());
+			body->SetAwake(true);
+		}
+	}
+}
+
+void createShapes(int width, int height)
+{
+	createBorders(width, height);
+
+	//createTriangle(width / 1.5f, tHeight / 2.0f, tWidth / 1.5f, tHeight * 2.0f, glm::radians(44.5f), glm::vec4(0.0f, 0.6f, 0.1f, 1.0f), true);
+	//createRectangle(0, height / 2.0f, tWidth * 4.0f, tHeight / 5.0f, glm::radians(15.0f), glm::vec4(0.0f, 0.4f, 0.2f, 1.0f), false);
+
+	//createRectangle(width / 2.0f, tHeight, tWidth / 4.0f, tHeight, glm::radians(44.5f), glm::vec4(1.0f, 0.0f, 0.8f, 1.0f), true);
+	//createRectangle(width / 3.0f, height / 2.0f, tWidth / 3.0f, tHeight / 3.0f, glm::radians(44.5f), glm::vec4(0.7f, 0.8f, 0.8f, 1.0f), true);
+}
+
+#pragma endregion
+
+#pragma region Program cache
+
+// Directory for cached program binaries; empty disables the cache.
+std::string programCacheDirectory;
+
+// Outcome of the last program load, for startup reporting.
+bool programFromCache = false;
+float programLoadMilliseconds = 0.0f;
+
+static const unsigned int ProgramCacheMagic = 0x41525043;
+
+unsigned long long hashBytes(const void* data, size_t size, unsigned long long hash = 14695981039346656037ULL)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+// Cache file layout: magic, binary format, driver name length, driver name,
+// binary. The file name carries the hash of sources and driver name; the
+// stored name guards against hash collisions.
+std::string programCachePath(unsigned long long key)
+{
+	char name[64];
+	snprintf(name, sizeof(name), "/program-%016llx.bin", key);
+	return programCacheDirectory + name;
+}
+
+unsigned int loadCachedProgram(const std::string& path, const std::string& driver)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file) return 0;
+
+	unsigned int header[3] = {};
+	std::string storedDriver;
+	std::vector<unsigned char> binary;
+
+	bool valid = fread(header, sizeof(header), 1, file) == 1 && header[0] == ProgramCacheMagic && header[2] == driver.size();
+	if (valid)
+	{
+		storedDriver.resize(header[2]);
+		valid = (header[2] == 0 || fread(&storedDriver[0], header[2], 1, file) == 1) && storedDriver == driver;
+	}
+	if (valid)
+	{
+		long start = ftell(file);
+		fseek(file, 0, SEEK_END);
+		binary.resize(ftell(file) - start);
+		fseek(file, start, SEEK_SET);
+		valid = !binary.empty() && fread(&binary[0], binary.size(), 1, file) == 1;
+	}
+
+	fclose(file);
+
+	return valid ? backend->createProgramFromBinary(header[1], binary) : 0;
+}
+
+void storeCachedProgram(const std::string& path, const std::string& driver, unsigned int program)
+{
+	std::vector<unsigned char> binary;
+	unsigned int format = 0;
+	if (!backend->getProgramBinary(program, binary, format)) return;
+
+	FILE* file = fopen(path.c_str(), "wb");
+	if (!file) return;
+
+	unsigned int header[3] = { ProgramCacheMagic, format, (unsigned int)driver.size() };
+	bool written = fwrite(header, sizeof(header), 1, file) == 1 &&
+		fwrite(driver.data(), driver.size(), 1, file) == 1 &&
+		fwrite(&binary[0], binary.size(), 1, file) == 1;
+
+	fclose(file);
+
+	if (!written) remove(path.c_str());
+}
+
+// Loads the linked program from the binary cache when the sources and
+// driver match, otherwise compiles from source and refreshes the cache.
+unsigned int loadProgram(const char* vertexSource, const char* fragmentSource)
+{
+	b2Timer timer;
+
+	std::string driver = programCacheDirectory.empty() ? std::string() : backend->driverName();
+	unsigned long long key = hashBytes(vertexSource, strlen(vertexSource));
+	key = hashBytes(fragmentSource, strlen(fragmentSource), key);
+	key = hashBytes(driver.data(), driver.size(), key);
+
+	unsigned int program = 0;
+	programFromCache = false;
+
+	if (!programCacheDirectory.empty())
+	{
+		program = loadCachedProgram(programCachePath(key), driver);
+		programFromCache = program != 0;
+	}
+
+	if (!program)
+	{
+		program = backend->createProgram(vertexSource, fragmentSource);
+
+		if (program && !programCacheDirectory.empty())
+		{
+			storeCachedProgram(programCachePath(key), driver, program);
+		}
+	}
+
+	programLoadMilliseconds = timer.GetMilliseconds();
+	LOGI("program: %s in %.3f ms\n", programFromCache ? "binary cache" : "compiled", programLoadMilliseconds);
+
+	return program;
+}
+
+#pragma endregion
+
+#pragma region Init graphics
+
+void startSimulation();
+void stopSimulation();
+void beginSession(int width, int height);
+void recordResize(int width, int height);
+
+// Time the last initGraphics took to rebuild GPU resources.
+float graphicsInitMilliseconds = 0.0f;
+
+// Creates everything owned by the GL context. The context is gone by the
+// time the surface is recreated, so old handles are dropped, not deleted.
+bool createGraphicsResources(int width, int height)
+{
+	backend->describe();
+
+	LOGI("setupGraphics(%d, %d)\n", width, height);
+
+	program = loadProgram(vertexShader, fragmentShader);
+	if (!program)
+	{
+		LOGE("Could not create program.");
+		return false;
+	}
+
+	mvpLocation = backend->getUniformLocation(program, "MVP");
+
+	batch.init();
+
+	backend->viewport(0, 0, width, height);
+	backend->clearColor(0.1f, 0.1f, 0.8f, 1.0f);
+
+	backend->setDepthTest(true);
+	backend->setBlending(true);
+
+	projection = glm::ortho(camera.x, camera.x + width, camera.y + height, camera.y);
+
+	return true;
+}
+
+// Called for every new surface. The world outlives the GL context, so only
+// the first call builds the scene; later ones rebuild GPU resources and
+// refit the borders if the size changed.
+void initGraphics(int width, int height)
+{
+	stopSimulation();
+
+	b2Timer timer;
+
+	bool resized = width != screenWidth || height != screenHeight;
+	screenWidth = width;
+	screenHeight = height;
+
+	if (!createGraphicsResources(width, height)) return;
+
+	graphicsInitMilliseconds = timer.GetMilliseconds();
+
+	if (scene.size() == 0)
+	{
+		beginSession(width, height);
+		createShapes(width, height);
+	}
+	else if (resized)
+	{
+		recordResize(width, height);
+		resizeShapes(width, height);
+	}
+
+	LOGI("initGraphics: GPU resources in %.3f ms, %u shapes kept\n", graphicsInitMilliseconds, (unsigned int)scene.size());
+
+	startSimulation();
+}
+
+#pragma endregion
+
+#pragma region Input
+
+enum InputType
+{
+	TouchDown,
+	TouchUp,
+	TouchMove
+};
+
+struct InputEvent
+{
+	InputType type;
+	float x, y;
+	long long time; // steady clock nanoseconds of the touch
+};
+
+// Wait-free queue from one producer thread to one consumer thread. Each
+// index is written by one side only; a full queue rejects the push.
+template <typename T, unsigned int Capacity>
+struct SpscQueue
+{
+	SpscQueue() : head(0), tail(0) {}
+
+	bool push(const T& item)
+	{
+		unsigned int index = tail.load(std::memory_order_relaxed);
+		if (index - head.load(std::memory_order_acquire) == Capacity) return false;
+
+		items[index % Capacity] = item;
+		tail.store(index + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& item)
+	{
+		unsigned int index = head.load(std::memory_order_relaxed);
+		if (index == tail.load(std::memory_order_acquire)) return false;
+
+		item = items[index % Capacity];
+		head.store(index + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool empty() const
+	{
+		return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+	}
+
+private:
+
+	T items[Capacity];
+	std::atomic<unsigned int> head;
+	std::atomic<unsigned int> tail;
+};
+
+// Filled by the UI thread, drained by the simulation at the start of each
+// fixed step, so input never touches the world mid-step.
+SpscQueue<InputEvent, 256> inputQueue;
+std::atomic<unsigned int> droppedInput(0);
+
+long long currentNanoseconds()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Time 0 stamps the event with the current time.
+void queueInput(InputType type, float x, float y, long long time = 0)
+{
+	InputEvent event = { type, x, y, time ? time : currentNanoseconds() };
+	if (!inputQueue.push(event)) droppedInput.fetch_add(1, std::memory_order_relaxed);
+}
+
+void touch(InputType type, float x, float y);
+void recordTouch(int type, float x, float y);
+
+// Oldest input handled since the last published snapshot, for the
+// touch-to-photon latency; 0 if none.
+long long pendingInputTime = 0;
+
+// Returns how many events were handled. Moves are coalesced: only the
+// last one before a down, an up or the end of the queue reaches touch(),
+// so a fast touch stream costs one joint update per step.
+unsigned int drainInput()
+{
+	unsigned int handled = 0;
+	bool moved = false;
+	InputEvent move;
+
+	InputEvent event;
+	while (inputQueue.pop(event))
+	{
+		recordTouch(event.type, event.x, event.y);
+
+		if (!pendingInputTime || event.time < pendingInputTime) pendingInputTime = event.time;
+		handled++;
+
+		if (event.type == TouchMove)
+		{
+			move = event;
+			moved = true;
+			continue;
+		}
+
+		if (moved) touch(TouchMove, move.x, move.y);
+		moved = false;
+
+		touch(event.type, event.x, event.y);
+	}
+
+	if (moved) touch(TouchMove, move.x, move.y);
+
+	return handled;
+}
+
+#pragma endregion
+
+#pragma region Update
+
+float accumulator = 0.0f;
+float step = 1.0f / 60.0f;
+long long updateTime = 0;
+float spawnRate = 0.5f;
+float spawnDebt = 0.0f;
+unsigned int spawnCount = 0;
+float backgroundFun = 0.0f;
+float clearR = 0.2f;
+float clearG = 0.3f;
+float clearB = 0.5f;
+
+// Set when update() ends with every body asleep and no input since the
+// last update; nothing then changes until the next spawn or touch. Read
+// by the view, together with the input queue, to stop rendering
+// continuously. Cleared as soon as a step starts handling input.
+std::atomic<bool> quiescent(false);
+bool worldIdle = false;
+unsigned int awakeBodies = 0;
+
+// Real time in milliseconds until the next spawn wakes the world, or -1
+// if spawning is off.
+std::atomic<int> wakeDelay(-1);
+
+// Called after every world.Step, e.g. to collect its b2Profile.
+void (*stepObserver)(const b2Profile& profile) = nullptr;
+
+// Longest stretch of time one update() catches up on at full quality.
+const float MaxCatchUp = 0.25f;
+
+enum SteppingMode
+{
+	FullQuality,
+	ReducedIterations,
+	ReducedSubsteps,
+	SlowMotion,
+	SteppingModeCount
+};
+
+const char* steppingModeName(SteppingMode mode)
+{
+	static const char* names[SteppingModeCount] = { "full quality", "reduced iterations", "reduced substeps", "slow motion" };
+	return names[mode];
+}
+
+struct SteppingLevel
+{
+	SteppingMode mode;
+	int velocityIterations;
+	int positionIterations;
+	int maxSubsteps; // 0 catches up on up to MaxCatchUp
+	float timeScale;
+};
+
+// Keeps the time update() spends in world.Step within a CPU budget. When
+// steps overrun it gives up solver iterations first, then catch-up steps,
+// then runs the world in slow motion; it climbs back one level at a time
+// once the cost is well under budget.
+struct StepController
+{
+	StepController() : budget(8.0f), level(0), cost(0.0f), settle(0) {}
+
+	const SteppingLevel& current() const
+	{
+		return levels()[level];
+	}
+
+	SteppingMode mode() const
+	{
+		return current().mode;
+	}
+
+	static SteppingMode levelMode(int level)
+	{
+		return levels()[level].mode;
+	}
+
+	int maxSubsteps() const
+	{
+		int substeps = current().maxSubsteps;
+		return substeps > 0 ? substeps : std::max((int)(MaxCatchUp / step), 1);
+	}
+
+	// Takes the summed b2Profile step time of one update().
+	void measure(float milliseconds)
+	{
+		cost += (milliseconds - cost) * 0.1f;
+
+		if (settle > 0)
+		{
+			settle--;
+			return;
+		}
+
+		if (budget <= 0.0f) return;
+
+		if (cost > budget && level + 1 < LevelCount)
+		{
+			setLevel(level + 1);
+			settle = DegradeFrames;
+		}
+		else if (cost < budget * 0.5f && level > 0)
+		{
+			setLevel(level - 1);
+			settle = RecoverFrames;
+		}
+	}
+
+	void reset()
+	{
+		level = 0;
+		cost = 0.0f;
+		settle = 0;
+	}
+
+	// Replays a recorded level; measure() leaves it alone with no budget.
+	void force(int newLevel)
+	{
+		if (newLevel >= 0 && newLevel < LevelCount) setLevel(newLevel);
+	}
+
+	float budget; // ms per update(); 0 keeps full quality
+	int level;
+	float cost;
+
+private:
+
+	static const int LevelCount = 8;
+	static const int DegradeFrames = 15;
+	static const int RecoverFrames = 60;
+
+	static const SteppingLevel* levels()
+	{
+		static const SteppingLevel table[LevelCount] =
+		{
+			{ FullQuality, 8, 3, 0, 1.0f },
+			{ ReducedIterations, 6, 2, 0, 1.0f },
+			{ ReducedIterations, 4, 1, 0, 1.0f },
+			{ ReducedSubsteps, 4, 1, 4, 1.0f },
+			{ ReducedSubsteps, 4, 1, 2, 1.0f },
+			{ ReducedSubsteps, 4, 1, 1, 1.0f },
+			{ SlowMotion, 4, 1, 1, 0.5f },
+			{ SlowMotion, 4, 1, 1, 0.25f },
+		};
+		return table;
+	}
+
+	void setLevel(int newLevel)
+	{
+		SteppingMode previous = mode();
+		level = newLevel;
+
+		if (mode() != previous)
+		{
+			LOGI("stepping: %s (%.2f ms/update, budget %.2f ms)\n", steppingModeName(mode()), cost, budget);
+		}
+	}
+
+	int settle;
+};
+
+StepController stepController;
+
+UpdateStats updateStats;
+
+void addProfile(b2Profile& sum, const b2Profile& profile)
+{
+	sum.step += profile.step;
+	sum.collide += profile.collide;
+	sum.solve += profile.solve;
+	sum.solveInit += profile.solveInit;
+	sum.solveVelocity += profile.solveVelocity;
+	sum.solvePosition += profile.solvePosition;
+	sum.broadphase += profile.broadphase;
+	sum.solveTOI += profile.solveTOI;
+
+	// Colors are counts, not times; keep the latest step's.
+	sum.colorCount = profile.colorCount;
+	memcpy(sum.colorSizes, profile.colorSizes, sizeof(sum.colorSizes));
+	sum.colorOverflow = profile.colorOverflow;
+}
+
+// Turns the times frames start at, which jitter with scheduling, into the
+// evenly spaced times they reach the display. Each frame is assigned the
+// vsync it started on, a missed vsync counting as two periods, and a line
+// fitted through the latest frames gives the refresh period and the grid
+// the frames sit on. Simulating up to the predicted present time then
+// steps the same amount of physics for every displayed frame.
+struct FramePacer
+{
+	static const long long NominalPeriod = 16666667;
+	static const long long MinPeriod = 4000000;
+	static const long long MaxPeriod = 50000000;
+
+	// Frames further apart than this many vsyncs are a stall; the grid is
+	// fitted again from scratch.
+	static const long long MaxVsyncs = 5;
+
+	static const int Window = 120;
+
+	FramePacer() : clock(currentNanoseconds), presentLatency(1) { reset(); }
+
+	void reset()
+	{
+		period = NominalPeriod;
+		vsync = 0;
+		present = 0;
+		samples = 0;
+		newest = 0;
+	}
+
+	// Takes the frame's start time in nanoseconds, or 0 to read the clock,
+	// and returns the time the frame is expected on screen.
+	long long frame(long long time = 0)
+	{
+		if (!time) time = clock();
+
+		long long vsyncs = std::max((time - vsync + period / 2) / period, 1LL);
+
+		if (samples == 0 || vsyncs > MaxVsyncs)
+		{
+			samples = 0;
+			add(0, time);
+			vsync = time;
+		}
+		else
+		{
+			add(counts[newest] + vsyncs, time);
+			fit();
+		}
+
+		present = vsync + presentLatency * period;
+		return present;
+	}
+
+	// Replaceable so the pacer can run against a simulated display.
+	long long (*clock)();
+
+	int presentLatency; // vsyncs from a frame's start to its present
+	long long period;
+	long long vsync; // fitted vsync the latest frame started on
+	long long present;
+
+private:
+
+	void add(long long count, long long time)
+	{
+		newest = samples ? (newest + 1) % Window : 0;
+		counts[newest] = count;
+		times[newest] = time;
+		if (samples < Window) samples++;
+	}
+
+	// Least squares over the window, relative to its oldest sample so the
+	// sums stay small whatever the uptime.
+	void fit()
+	{
+		int oldest = (newest + Window - samples + 1) % Window;
+
+		double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+		for (int i = 0; i < samples; i++)
+		{
+			int j = (oldest + i) % Window;
+			double x = (double)(counts[j] - counts[oldest]);
+			double y = (double)(times[j] - times[oldest]);
+			sumX += x;
+			sumY += y;
+			sumXX += x * x;
+			sumXY += x * y;
+		}
+
+		double variance = samples * sumXX - sumX * sumX;
+		if (variance <= 0.0) return;
+
+		double slope = (samples * sumXY - sumX * sumY) / variance;
+		double intercept = (sumY - slope * sumX) / samples;
+
+		if (slope < MinPeriod) slope = MinPeriod; else if (slope > MaxPeriod) slope = MaxPeriod;
+
+		period = (long long)(slope + 0.5);
+		vsync = times[oldest] + (long long)(intercept + slope * (counts[newest] - counts[oldest]) + 0.5);
+	}
+
+	long long counts[Window]; // vsyncs since the grid was started
+	long long times[Window];
+	int samples;
+	int newest;
+};
+
+FramePacer framePacer;
+
+void recordUpdate(long long time, unsigned int spawned, int level);
+
+// Advances the world to time, in steady clock nanoseconds.
+void update(long long time)
+{
+	b2Timer timer;
+	b2Profile profile = {};
+
+	const SteppingLevel& level = stepController.current();
+	int maxSubsteps = stepController.maxSubsteps();
+
+	// Kept in 64-bit nanoseconds until the difference, so neither uptime
+	// nor frame deltas lose precision.
+	float deltaTime = std::max(time - updateTime, 0LL) / 1e9f * level.timeScale;
+	updateTime = time;
+
+	accumulator += deltaTime;
+
+	float cost = 0.0f;
+	int substeps = 0;
+	unsigned int spawned = 0;
+	unsigned int input = 0;
+
+	bool idle = worldIdle;
+
+	while (accumulator >= step && substeps < maxSubsteps)
+	{
+		// The clear color holds still while idle, otherwise it alone would
+		// keep every idle frame different.
+		if (!idle)
+		{
+			clearR += RandomFloat(-0.01f, 0.01f)(generator);
+			clearG += RandomFloat(-0.01f, 0.01f)(generator);
+			clearB += RandomFloat(-0.01f, 0.01f)(generator);
+
+			if (clearR > 1.0f) clearR = 1.0f; else if (clearR < 0.0f) clearR = 0.0f;
+			if (clearG > 1.0f) clearG = 1.0f; else if (clearG < 0.0f) clearG = 0.0f;
+			if (clearB > 1.0f) clearB = 1.0f; else if (clearB < 0.0f) clearB = 0.0f;
+		}
+
+		if (!inputQueue.empty())
+		{
+			quiescent.store(false);
+			input += drainInput();
+		}
+
+		scene.savePrevious();
+
+		world.Step(step, level.velocityIterations, level.positionIterations);
+
+		cost += world.GetProfile().step;
+		addProfile(profile, world.GetProfile());
+
+		if (stepObserver) stepObserver(world.GetProfile());
+
+		currentTime += step;
+		awakeBodies = scene.updateSleep(currentTime);
+
+		accumulator -= step;
+		substeps++;
+
+		// Spawns in simulation time, so high rates add several shapes per step.
+		spawnDebt += step * spawnRate;
+		while (spawnDebt >= 1.0f)
+		{
+			createShape();
+			spawned++;
+			spawnCount++;
+
+			spawnDebt -= 1.0f;
+		}
+	}
+
+	// Time the substep cap could not catch up on is dropped rather than
+	// carried into the next frame.
+	if (accumulator >= step) accumulator = fmodf(accumulator, step);
+
+	stepController.measure(cost);
+
+	// Queued but undrained input is left to isIdle(), so a replay, which
+	// queues input at different moments, makes the same choices.
+	worldIdle = awakeBodies == 0 && spawned == 0 && input == 0;
+	quiescent.store(worldIdle);
+
+	float rate = spawnRate * stepController.current().timeScale;
+	wakeDelay.store(rate > 0.0f ? (int)ceilf((1.0f - spawnDebt) / rate * 1000.0f) : -1);
+
+	recordUpdate(time, spawned, stepController.level);
+
+	updateStats.substeps = substeps;
+	updateStats.level = stepController.level;
+	updateStats.profile = profile;
+	updateStats.bodies = world.GetBodyCount();
+	updateStats.contacts = world.GetContactCount();
+	updateStats.proxies = world.GetProxyCount();
+	updateStats.inputEvents = input;
+	updateStats.milliseconds = timer.GetMilliseconds();
+}
+
+#pragma endregion
+
+#pragma region Session log
+
+// Records everything that makes a run differ from another: the seed, the
+// scene settings, every time passed to update() and every touch. Spawns
+// and stepping level changes are logged as well; the spawns let a replay
+// detect that it diverged, the levels make the adaptive stepping repeat
+// the recorded decisions instead of timing this machine.
+//
+// File: header, then events of one type byte and a payload. Frame times
+// are stored as varint nanosecond deltas, so a typical frame costs five
+// bytes.
+
+enum SessionEvent
+{
+	FrameEvent,
+	SpawnEvent,
+	LevelEvent,
+	TouchEvent,
+	ResizeEvent
+};
+
+struct SessionHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int seed;
+	float step;
+	float spawnRate;
+	int populationCap;
+	int retirementPolicy;
+	float currentTime;
+	int shapeSize;
+	int width;
+	int height;
+	long long updateTime;
+	int graphColoring;
+};
+
+struct SessionLog
+{
+	SessionLog() : file(nullptr), replaying(false), lastTime(0), lastLevel(0) {}
+
+	// Starts writing to path, reseeding the scene so the seed is known.
+	bool startRecording(const std::string& path, int width, int height)
+	{
+		stop();
+
+		file = fopen(path.c_str(), "wb");
+		if (!file)
+		{
+			LOGE("Could not record to %s\n", path.c_str());
+			return false;
+		}
+
+		generator.seed(seed);
+
+		SessionHeader header = { { 'A', 'R', 'S', 'L' }, Version, seed, step, spawnRate, populationCap, retirementPolicy, currentTime, shapeSize, width, height, updateTime, world.GetGraphColoring() };
+		fwrite(&header, sizeof(header), 1, file);
+
+		replaying = false;
+		lastTime = 0;
+		lastLevel = 0;
+		return true;
+	}
+
+	// Opens a recording and applies its seed and settings; the caller
+	// then creates the scene at the header's size and calls next().
+	bool startReplay(const std::string& path, SessionHeader& header)
+	{
+		stop();
+
+		file = fopen(path.c_str(), "rb");
+		if (!file) return false;
+
+		if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, "ARSL", 4) || header.version != Version)
+		{
+			stop();
+			return false;
+		}
+
+		seed = header.seed;
+		generator.seed(seed);
+		step = header.step;
+		spawnRate = header.spawnRate;
+		populationCap = header.populationCap;
+		retirementPolicy = (RetirementPolicy)header.retirementPolicy;
+		currentTime = header.currentTime;
+		updateTime = header.updateTime;
+		shapeSize = header.shapeSize;
+		world.SetGraphColoring(header.graphColoring != 0);
+		accumulator = 0.0f;
+		stepController.budget = 0.0f;
+		stepController.reset();
+
+		replaying = true;
+		lastTime = 0;
+		return true;
+	}
+
+	void stop()
+	{
+		if (file) fclose(file);
+		file = nullptr;
+		replaying = false;
+	}
+
+	bool recording() const
+	{
+		return file && !replaying;
+	}
+
+	void frame(long long time, unsigned int spawned, int level)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!recording()) return;
+
+		fputc(FrameEvent, file);
+		writeVarint(zigzag(time - lastTime));
+		lastTime = time;
+
+		if (spawned > 0)
+		{
+			fputc(SpawnEvent, file);
+			writeVarint(spawned);
+		}
+
+		if (level != lastLevel)
+		{
+			fputc(LevelEvent, file);
+			fputc(level, file);
+			lastLevel = level;
+		}
+	}
+
+	void touch(int type, float x, float y)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!recording()) return;
+
+		float position[2] = { x, y };
+		fputc(TouchEvent, file);
+		fputc(type, file);
+		fwrite(position, sizeof(position), 1, file);
+	}
+
+	void resize(int width, int height)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!recording()) return;
+
+		fputc(ResizeEvent, file);
+		writeVarint(width);
+		writeVarint(height);
+	}
+
+	void flush()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (file) fflush(file);
+	}
+
+	// Reads the next replay event. Frame times, spawn counts, levels and
+	// touch types come back in value, positions and surface sizes in x and y.
+	bool next(SessionEvent& event, long long& value, float& x, float& y)
+	{
+		if (!file || !replaying) return false;
+
+		int type = fgetc(file);
+		if (type == EOF) return false;
+
+		event = (SessionEvent)type;
+
+		switch (event)
+		{
+		case FrameEvent:
+			lastTime += unzigzag(readVarint());
+			value = lastTime;
+			return true;
+		case SpawnEvent:
+			value = (long long)readVarint();
+			return true;
+		case LevelEvent:
+			value = fgetc(file);
+			return value != EOF;
+		case TouchEvent:
+		{
+			float position[2];
+			value = fgetc(file);
+			if (value == EOF || fread(position, sizeof(position), 1, file) != 1) return false;
+			x = position[0];
+			y = position[1];
+			return true;
+		}
+		case ResizeEvent:
+			x = (float)readVarint();
+			y = (float)readVarint();
+			return true;
+		}
+
+		return false;
+	}
+
+private:
+
+	static const unsigned int Version = 4;
+
+	static unsigned long long zigzag(long long value)
+	{
+		return ((unsigned long long)value << 1) ^ (unsigned long long)(value >> 63);
+	}
+
+	static long long unzigzag(unsigned long long value)
+	{
+		return (long long)(value >> 1) ^ -(long long)(value & 1);
+	}
+
+	void writeVarint(unsigned long long value)
+	{
+		while (value >= 0x80)
+		{
+			fputc((int)(value & 0x7f) | 0x80, file);
+			value >>= 7;
+		}
+		fputc((int)value, file);
+	}
+
+	unsigned long long readVarint()
+	{
+		unsigned long long value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			int byte = fgetc(file);
+			if (byte == EOF) break;
+
+			value |= (unsigned long long)(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) break;
+		}
+		return value;
+	}
+
+	FILE* file;
+	bool replaying;
+	long long lastTime;
+	int lastLevel;
+	std::mutex mutex;
+};
+
+SessionLog sessionLog;
+
+// Where initGraphics starts recording when it creates the scene; empty
+// records nothing.
+std::string sessionRecordPath;
+
+void beginSession(int width, int height)
+{
+	if (!sessionRecordPath.empty()) sessionLog.startRecording(sessionRecordPath, width, height);
+}
+
+void recordResize(int width, int height)
+{
+	sessionLog.resize(width, height);
+}
+
+void recordUpdate(long long time, unsigned int spawned, int level)
+{
+	sessionLog.frame(time, spawned, level);
+}
+
+void recordTouch(int type, float x, float y)
+{
+	sessionLog.touch(type, x, y);
+}
+
+#pragma endregion
+
+#pragma region Simulation
+
+#ifndef ANTROIT_HEADLESS
+bool threadedPhysics = true;
+#else
+bool threadedPhysics = false;
+#endif
+
+std::thread simulationThread;
+std::atomic<bool> simulationRunning(false);
+
+// The frame pacer's predicted present of the next frame, published by the
+// render thread after each draw. The simulation thread steps up to it, so
+// the snapshot that frame draws holds the state it shows. 0 before the
+// first frame.
+std::atomic<long long> pacedTime(0);
+std::mutex pacedMutex;
+std::condition_variable pacedChanged;
+
+// Steps the simulation thread waits for a paced time while not idle before
+// stepping on its own; a surface being rebuilt can hold frames back.
+static const int StalledFrameSteps = 6;
+
+// The time the simulation thread last stepped to, and its substeps since
+// the render thread last took them.
+std::atomic<long long> simulatedTime(0);
+std::atomic<int> simulatedSubsteps(0);
+
+// Predicted present of the frame being drawn; 0 interpolates at the clock.
+long long drawTime = 0;
+
+bool viewCulling = true;
+
+// Collects the scene entries of every fixture the broadphase reports.
+// Shapes have one fixture each, so every body is reported at most once.
+struct VisibilityQuery : public b2QueryCallback
+{
+	bool ReportFixture(b2Fixture* fixture)
+	{
+		unsigned int slot = (unsigned int)(size_t)fixture->GetBody()->GetUserData();
+		visible.push_back(scene.indexOfSlot(slot));
+		return true;
+	}
+
+	std::vector<unsigned int> visible;
+};
+
+VisibilityQuery visibilityQuery;
+
+// Asks the broadphase which shapes overlap the view, so snapshot and draw
+// cost follow what is on screen rather than the size of the world.
+void cullToView()
+{
+	// Pad by a little so bodies moving in between steps are already there.
+	float margin = std::max(tWidth, tHeight);
+
+	b2AABB view;
+	view.lowerBound = worldToBox2D(camera.x - margin, camera.y - margin);
+	view.upperBound = worldToBox2D(camera.x + screenWidth + margin, camera.y + screenHeight + margin);
+
+	visibilityQuery.visible.clear();
+	world.QueryAABB(&visibilityQuery, view);
+}
+
+bool drawnBefore(unsigned int a, unsigned int b)
+{
+	return scene.sequences[a] < scene.sequences[b];
+}
+
+void publishSnapshot()
+{
+	Snapshot& snapshot = snapshots.writeBuffer();
+
+	std::vector<unsigned int>& visible = visibilityQuery.visible;
+
+	if (viewCulling)
+	{
+		cullToView();
+	}
+	else
+	{
+		visible.resize(scene.size());
+		for (unsigned int i = 0; i < visible.size(); i++) visible[i] = i;
+	}
+
+	// Snapshots go back to front, the order the renderer layers them in.
+	std::sort(visible.begin(), visible.end(), drawnBefore);
+	scene.snapshot(visible, snapshot.bodies);
+
+	snapshot.culled = scene.size() - snapshot.bodies.size();
+
+	snapshot.clearColor = glm::vec3(clearR, clearG, clearB);
+	snapshot.alpha = accumulator / step;
+	snapshot.step = step;
+	snapshot.time = updateTime;
+	snapshot.update = updateStats;
+	snapshot.inputTime = pendingInputTime;
+	pendingInputTime = 0;
+
+	snapshots.publish();
+}
+
+// Owns the world while running: steps it to each new paced time and
+// publishes a snapshot after every update, independently of the GL thread.
+// paced is the paced time at start, already stepped to or stale.
+void simulate(long long paced)
+{
+	while (simulationRunning.load())
+	{
+		// Without frames, as when idle stops rendering, it steps on the
+		// pacer's clock once a step so spawns and input still get through.
+		std::chrono::nanoseconds timeout((long long)(step * 1e9f) * (worldIdle ? 1 : StalledFrameSteps));
+		{
+			std::unique_lock<std::mutex> lock(pacedMutex);
+			pacedChanged.wait_for(lock, timeout, [&paced] { return pacedTime.load() != paced || !simulationRunning.load(); });
+		}
+
+		if (!simulationRunning.load()) break;
+
+		long long next = pacedTime.load();
+		long long time = next != paced ? next : framePacer.clock();
+		paced = next;
+
+		update(std::max(time, updateTime));
+		publishSnapshot();
+
+		simulatedSubsteps += updateStats.substeps;
+		simulatedTime.store(updateTime);
+	}
+}
+
+// Hands the simulation thread the time to step to next.
+void pacePhysics(long long time)
+{
+	{
+		std::lock_guard<std::mutex> lock(pacedMutex);
+		pacedTime.store(time);
+	}
+	pacedChanged.notify_one();
+}
+
+// Start and stop run on the GL thread only, as initGraphics does on every
+// surface; the Java side queues pause and resume there. Before the first
+// surface the settings below may also call them from the UI thread, while
+// no GL thread exists yet.
+void startSimulation()
+{
+	if (!threadedPhysics || simulationRunning.load() || screenWidth == 0) return;
+
+	simulationRunning.store(true);
+	simulationThread = std::thread(simulate, pacedTime.load());
+}
+
+void stopSimulation()
+{
+	if (!simulationRunning.load()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(pacedMutex);
+		simulationRunning.store(false);
+	}
+	pacedChanged.notify_one();
+	simulationThread.join();
+}
+
+// Physics may run slower than the display; the renderer interpolates
+// between steps, so e.g. 30 Hz physics still moves smoothly at 60 Hz.
+void setPhysicsRate(float hz)
+{
+	if (hz <= 0.0f) return;
+
+	bool running = simulationRunning.load();
+	stopSimulation();
+
+	step = 1.0f / hz;
+	accumulator = 0.0f;
+	stepController.reset();
+
+	if (running) startSimulation();
+}
+
+// CPU time per update() the world may use before stepping degrades.
+void setStepBudget(float milliseconds)
+{
+	bool running = simulationRunning.load();
+	stopSimulation();
+
+	stepController.budget = std::max(milliseconds, 0.0f);
+	stepController.reset();
+
+	if (running) startSimulation();
+}
+
+// Threads world.Step solves islands on, counting the one calling it.
+void setPhysicsThreads(int count)
+{
+	bool running = simulationRunning.load();
+	stopSimulation();
+
+	world.SetThreadCount(std::max(count, 1));
+
+	if (running) startSimulation();
+}
+
+// Spreads the constraints of one big pile over the physics threads too.
+// This changes the simulation, so recordings keep the setting.
+void setGraphColoring(bool enabled)
+{
+	bool running = simulationRunning.load();
+	stopSimulation();
+
+	world.SetGraphColoring(enabled);
+
+	if (running) startSimulation();
+}
+
+void setPopulation(int cap, RetirementPolicy policy)
+{
+	bool running = simulationRunning.load();
+	stopSimulation();
+
+	populationCap = std::max(cap, 0);
+	retirementPolicy = policy;
+
+	if (running) startSimulation();
+}
+
+// How far the renderer is between the snapshot's previous and current
+// state. On the simulation thread the snapshot is normally of the frame's
+// predicted present already; if it fell behind, time has moved on since.
+float interpolationAlpha(const Snapshot& snapshot)
+{
+	float alpha = snapshot.alpha;
+
+	if (threadedPhysics && snapshot.step > 0.0f)
+	{
+		long long time = drawTime ? drawTime : currentNanoseconds();
+		alpha += (time - snapshot.time) / 1e9f / snapshot.step;
+	}
+
+	return std::min(std::max(alpha, 0.0f), 1.0f);
+}
+
+#pragma endregion
+
+#pragma region Telemetry
+
+struct FrameTelemetry
+{
+	UpdateStats update;
+	float drawMilliseconds;
+	float inputLatency; // touch to the end of the first draw showing it; 0 without input
+	RenderStats render;
+	unsigned int visible;
+	unsigned int culled;
+};
+
+// Keeps the last Capacity frames for readers on any thread. The render
+// thread is the only writer; each slot carries a sequence number that is
+// odd while the slot is written, so a reader drops any frame that changed
+// under it instead of locking. Histograms of update, step and draw time
+// cover the same window: a frame's bucket is counted when it enters the
+// ring and uncounted when it is overwritten.
+struct Telemetry
+{
+	static const unsigned int Capacity = 256;
+	static const int BucketCount = 9;
+
+	enum Histogram
+	{
+		UpdateHistogram,
+		StepHistogram,
+		DrawHistogram,
+		InputHistogram,
+		HistogramCount
+	};
+
+	Telemetry() : head(0)
+	{
+		for (auto& sequence : sequences) sequence.store(0);
+		for (auto& histogram : histograms) for (auto& count : histogram) count.store(0);
+	}
+
+	void push(const FrameTelemetry& frame)
+	{
+		unsigned long long index = head.load(std::memory_order_relaxed);
+		unsigned int slot = index % Capacity;
+
+		if (index >= Capacity) count(frames[slot], -1);
+
+		unsigned int sequence = sequences[slot].load(std::memory_order_relaxed);
+		sequences[slot].store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		frames[slot] = frame;
+
+		sequences[slot].store(sequence + 2, std::memory_order_release);
+		head.store(index + 1, std::memory_order_release);
+
+		count(frame, 1);
+	}
+
+	// Copies the frames in the window, oldest first, and returns how many
+	// frames were ever pushed.
+	unsigned long long read(std::vector<FrameTelemetry>& out) const
+	{
+		out.clear();
+
+		unsigned long long end = head.load(std::memory_order_acquire);
+		unsigned long long begin = end > Capacity ? end - Capacity : 0;
+
+		for (unsigned long long index = begin; index < end; index++)
+		{
+			unsigned int slot = index % Capacity;
+
+			unsigned int before = sequences[slot].load(std::memory_order_acquire);
+			FrameTelemetry frame = frames[slot];
+			std::atomic_thread_fence(std::memory_order_acquire);
+			unsigned int after = sequences[slot].load(std::memory_order_relaxed);
+
+			if (before == after && !(before & 1)) out.push_back(frame);
+		}
+
+		return end;
+	}
+
+	unsigned int bucketCount(Histogram histogram, int bucket) const
+	{
+		return histograms[histogram][bucket].load(std::memory_order_relaxed);
+	}
+
+	// Upper edge of a bucket in milliseconds: 0.25, 0.5, 1 ... 32, then
+	// everything above.
+	static float bucketEdge(int bucket)
+	{
+		return ldexpf(0.25f, bucket);
+	}
+
+private:
+
+	static int bucketOf(float milliseconds)
+	{
+		int bucket = 0;
+		while (bucket + 1 < BucketCount && milliseconds >= bucketEdge(bucket)) bucket++;
+		return bucket;
+	}
+
+	void count(const FrameTelemetry& frame, int delta)
+	{
+		histograms[UpdateHistogram][bucketOf(frame.update.milliseconds)].fetch_add(delta, std::memory_order_relaxed);
+		histograms[StepHistogram][bucketOf(frame.update.profile.step)].fetch_add(delta, std::memory_order_relaxed);
+		histograms[DrawHistogram][bucketOf(frame.drawMilliseconds)].fetch_add(delta, std::memory_order_relaxed);
+		if (frame.inputLatency > 0.0f) histograms[InputHistogram][bucketOf(frame.inputLatency)].fetch_add(delta, std::memory_order_relaxed);
+	}
+
+	std::atomic<unsigned long long> head;
+	FrameTelemetry frames[Capacity];
+	std::atomic<unsigned int> sequences[Capacity];
+	std::atomic<unsigned int> histograms[HistogramCount][BucketCount];
+};
+
+Telemetry telemetry;
+
+// Summarizes the telemetry window as JSON: the latest frame, means and
+// maxima over the window and the histograms.
+std::string telemetrySnapshot()
+{
+	std::vector<FrameTelemetry> frames;
+	unsigned long long total = telemetry.read(frames);
+
+	FrameTelemetry mean = {};
+	FrameTelemetry maximum = {};
+	unsigned int inputFrames = 0;
+	float lastInputLatency = 0.0f;
+
+	for (const auto& frame : frames)
+	{
+		if (frame.inputLatency > 0.0f)
+		{
+			mean.inputLatency += frame.inputLatency;
+			maximum.inputLatency = std::max(maximum.inputLatency, frame.inputLatency);
+			lastInputLatency = frame.inputLatency;
+			inputFrames++;
+		}
+
+		mean.update.milliseconds += frame.update.milliseconds;
+		mean.update.profile.step += frame.update.profile.step;
+		mean.update.substeps += frame.update.substeps;
+		mean.drawMilliseconds += frame.drawMilliseconds;
+
+		maximum.update.milliseconds = std::max(maximum.update.milliseconds, frame.update.milliseconds);
+		maximum.update.profile.step = std::max(maximum.update.profile.step, frame.update.profile.step);
+		maximum.update.substeps = std::max(maximum.update.substeps, frame.update.substeps);
+		maximum.drawMilliseconds = std::max(maximum.drawMilliseconds, frame.drawMilliseconds);
+	}
+
+	float n = frames.empty() ? 1.0f : (float)frames.size();
+	// The mode comes from the newest record too; the step controller belongs
+	// to the simulation thread.
+	FrameTelemetry latest = frames.empty() ? FrameTelemetry() : frames.back();
+	const b2Profile& profile = latest.update.profile;
+
+	char buffer[2048];
+	int length = snprintf(buffer, sizeof(buffer),
+		"{\"frames\":%llu,\"window\":%u,\"mode\":\"%s\","
+		"\"latest\":{\"update\":%.3f,\"draw\":%.3f,\"substeps\":%d,"
+		"\"profile\":{\"step\":%.3f,\"collide\":%.3f,\"solve\":%.3f,\"solveInit\":%.3f,\"solveVelocity\":%.3f,\"solvePosition\":%.3f,\"broadphase\":%.3f,\"solveTOI\":%.3f,\"colors\":%d},"
+		"\"bodies\":%u,\"contacts\":%u,\"proxies\":%u,\"visible\":%u,\"culled\":%u,"
+		"\"drawCalls\":%u,\"vertices\":%u,\"bytesUploaded\":%u},"
+		"\"mean\":{\"update\":%.3f,\"step\":%.3f,\"draw\":%.3f,\"substeps\":%.2f},"
+		"\"max\":{\"update\":%.3f,\"step\":%.3f,\"draw\":%.3f,\"substeps\":%d},",
+		total, (unsigned int)frames.size(), steppingModeName(StepController::levelMode(latest.update.level)),
+		latest.update.milliseconds, latest.drawMilliseconds, latest.update.substeps,
+		profile.step, profile.collide, profile.solve, profile.solveInit, profile.solveVelocity, profile.solvePosition, profile.broadphase, profile.solveTOI, profile.colorCount,
+		latest.update.bodies, latest.update.contacts, latest.update.proxies, latest.visible, latest.culled,
+		latest.render.drawCalls, latest.render.vertices, latest.render.bytesUploaded,
+		mean.update.milliseconds / n, mean.update.profile.step / n, mean.drawMilliseconds / n, mean.update.substeps / n,
+		maximum.update.milliseconds, maximum.update.profile.step, maximum.drawMilliseconds, maximum.update.substeps);
+
+	std::string json(buffer, std::min(length, (int)sizeof(buffer) - 1));
+
+	// Touch to the end of the first draw showing it, over frames with input.
+	snprintf(buffer, sizeof(buffer), "\"input\":{\"frames\":%u,\"latest\":%.3f,\"mean\":%.3f,\"max\":%.3f,\"dropped\":%u},",
+		inputFrames, lastInputLatency, inputFrames ? mean.inputLatency / inputFrames : 0.0f, maximum.inputLatency,
+		droppedInput.load(std::memory_order_relaxed));
+	json += buffer;
+
+	static const char* names[Telemetry::HistogramCount] = { "update", "step", "draw", "input" };
+
+	json += "\"histograms\":{\"edges\":[";
+	for (int bucket = 0; bucket + 1 < Telemetry::BucketCount; bucket++)
+	{
+		snprintf(buffer, sizeof(buffer), "%s%g", bucket ? "," : "", Telemetry::bucketEdge(bucket));
+		json += buffer;
+	}
+	json += "]";
+
+	for (int histogram = 0; histogram < Telemetry::HistogramCount; histogram++)
+	{
+		json += ",\"";
+		json += names[histogram];
+		json += "\":[";
+		for (int bucket = 0; bucket < Telemetry::BucketCount; bucket++)
+		{
+			snprintf(buffer, sizeof(buffer), "%s%u", bucket ? "," : "", telemetry.bucketCount((Telemetry::Histogram)histogram, bucket));
+			json += buffer;
+		}
+		json += "]";
+	}
+
+	json += "}}";
+	return json;
+}
+
+#pragma endregion
+
+#pragma region Touch
+
+// Static body with no fixtures for drag joints to hang from.
+b2Body* dragAnchor = nullptr;
+
+struct PointQuery : public b2QueryCallback
+{
+	bool ReportFixture(b2Fixture* fixture)
+	{
+		b2Body* body = fixture->GetBody();
+
+		if (body->GetType() == b2_dynamicBody && fixture->TestPoint(point))
+		{
+			found = body;
+			return false;
+		}
+
+		return true;
+	}
+
+	b2Vec2 point;
+	b2Body* found;
+};
+
+// Screen position to Box2D coordinates.
+b2Vec2 touchPoint(float x, float y)
+{
+	return b2Vec2(worldToBox2D(camera.x + x), worldToBox2D(camera.y + y));
+}
+
+// Picks the body under the finger through the broadphase and attaches a
+// mouse joint that pulls it toward the finger.
+void startDrag(float x, float y)
+{
+	releaseDrag();
+
+	PointQuery query;
+	query.point = touchPoint(x, y);
+	query.found = nullptr;
+
+	b2AABB box;
+	box.lowerBound = query.point - b2Vec2(0.001f, 0.001f);
+	box.upperBound = query.point + b2Vec2(0.001f, 0.001f);
+	world.QueryAABB(&query, box);
+
+	if (!query.found) return;
+
+	if (!dragAnchor)
+	{
+		b2BodyDef definition;
+		dragAnchor = world.CreateBody(&definition);
+	}
+
+	b2MouseJointDef definition;
+	definition.bodyA = dragAnchor;
+	definition.bodyB = query.found;
+	definition.target = query.point;
+	definition.maxForce = 1000.0f * query.found->GetMass();
+	definition.frequencyHz = 5.0f;
+	definition.dampingRatio = 0.7f;
+	dragJoint = (b2MouseJoint*)world.CreateJoint(&definition);
+
+	query.found->SetAwake(true);
+}
+
+void touch(InputType type, float x, float y)
+{
+	switch (type)
+	{
+	case TouchDown:
+		startDrag(x, y);
+		break;
+	case TouchMove:
+		if (dragJoint) dragJoint->SetTarget(touchPoint(x, y));
+		break;
+	case TouchUp:
+		releaseDrag();
+		break;
+	}
+}
+
+#pragma endregion
+
+#pragma region Draw
+
+int statsFrame = 0;
+static const int StatsInterval = 300;
+
+void draw()
+{
+	b2Timer timer;
+
+	bool fresh = snapshots.consume();
+	const Snapshot& snapshot = snapshots.readBuffer();
+
+	backend->stats = RenderStats();
+
+	backend->clearColor(snapshot.clearColor.r, snapshot.clearColor.g, snapshot.clearColor.b, 1.0f);
+	backend->clear();
+
+	backend->useProgram(program);
+
+	float alpha = interpolationAlpha(snapshot);
+
+	batch.begin(camera);
+
+	unsigned int count = snapshot.bodies.size();
+
+	for (unsigned int i = count; i-- > 0;)
+	{
+		const BodySnapshot& body = snapshot.bodies[i];
+		if (Batch::isOpaque(body)) batch.add(body, alpha, Batch::layerDepth(i, count), OpaquePass);
+	}
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const BodySnapshot& body = snapshot.bodies[i];
+		if (!Batch::isOpaque(body)) batch.add(body, alpha, Batch::layerDepth(i, count), TranslucentPass);
+	}
+
+	batch.flush();
+
+	backend->useProgram(0);
+
+	FrameTelemetry frame;
+	frame.update = snapshot.update;
+	frame.render = backend->stats;
+	frame.visible = snapshot.bodies.size();
+	frame.culled = snapshot.culled;
+	frame.drawMilliseconds = timer.GetMilliseconds();
+	frame.inputLatency = fresh && snapshot.inputTime ? (currentNanoseconds() - snapshot.inputTime) / 1000000.0f : 0.0f;
+	telemetry.push(frame);
+
+	if (++statsFrame >= StatsInterval)
+	{
+		const RenderStats& stats = backend->stats;
+		LOGI("draw: %u visible, %u culled, %u draw calls, %u vertices, %u bytes uploaded\n",
+			(unsigned int)snapshot.bodies.size(), snapshot.culled, stats.drawCalls, stats.vertices, stats.bytesUploaded);
+		statsFrame = 0;
+	}
+}
+
+#pragma endregion
+
+#ifndef ANTROIT_HEADLESS
+
+#pragma region Java
+
+extern "C"
+{
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_init(JNIEnv* env, jobject obj, jint width, jint height)
+	{
+		initGraphics(width, height);
+	}
+
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_setCacheDirectory(JNIEnv* env, jobject obj, jstring path)
+	{
+		const char* chars = env->GetStringUTFChars(path, nullptr);
+		programCacheDirectory = chars;
+		env->ReleaseStringUTFChars(path, chars);
+	}
+
+	// The time is System.nanoTime() at the start of the frame, on the same
+	// monotonic clock as steady_clock.
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_step(JNIEnv* env, jobject obj, jlong time)
+	{
+		long long present = framePacer.frame(time);
+		drawTime = present;
+
+		if (!threadedPhysics)
+		{
+			update(present);
+			publishSnapshot();
+		}
+
 		draw();
+
+		// The next frame is due a refresh later; the simulation thread
+		// steps to it while this one is on screen.
+		if (threadedPhysics) pacePhysics(present + framePacer.period);
+	}
+
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_setPhysicsRate(JNIEnv* env, jobject obj, jfloat hz)
+	{
+		setPhysicsRate(hz);
+	}
+
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_setPopulation(JNIEnv* env, jobject obj, jint cap, jint policy)
+	{
+		setPopulation(cap, static_cast<RetirementPolicy>(policy));
+	}
+
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_setStepBudget(JNIEnv* env, jobject obj, jfloat milliseconds)
+	{
+		setStepBudget(milliseconds);
+	}
+
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_setPhysicsThreads(JNIEnv* env, jobject obj, jint count)
+	{
+		setPhysicsThreads(count);
+	}
+
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_setGraphColoring(JNIEnv* env, jobject obj, jboolean enabled)
+	{
+		setGraphColoring(enabled != 0);
+	}
+
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_setRecordPath(JNIEnv* env, jobject obj, jstring path)
+	{
+		const char* chars = env->GetStringUTFChars(path, nullptr);
+		sessionRecordPath = chars;
+		env->ReleaseStringUTFChars(path, chars);
+	}
+
+	JNIEXPORT jstring JNICALL Java_fi_enko_antroit_AntRoitLib_getTelemetry(JNIEnv* env, jobject obj)
+	{
+		return env->NewStringUTF(telemetrySnapshot().c_str());
+	}
+
+	JNIEXPORT jboolean JNICALL Java_fi_enko_antroit_AntRoitLib_isIdle(JNIEnv* env, jobject obj)
+	{
+		return quiescent.load() && inputQueue.empty();
+	}
+
+	JNIEXPORT jint JNICALL Java_fi_enko_antroit_AntRoitLib_getWakeDelay(JNIEnv* env, jobject obj)
+	{
+		return wakeDelay.load();
+	}
+
+	// Pause and resume are queued on the GL thread, like init.
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_pause(JNIEnv* env, jobject obj)
+	{
+		stopSimulation();
+		sessionLog.flush();
+	}
+
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_resume(JNIEnv* env, jobject obj)
+	{
+		startSimulation();
+	}
+
+	// The event time is in uptime milliseconds, which count on the same
+	// monotonic clock as steady_clock.
+	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_touch(JNIEnv* env, jobject obj, jint action, jfloat x, jfloat y, jlong eventTime)
+	{
+		queueInput((InputType)action, x, y, eventTime * 1000000LL);
+	}
+}
+
+#pragma endregion
+
+#else
+
+#pragma region Headless
+
+// Per-shape heap object laid out like the old Shape class, for comparison.
+struct PointerShape
+{
+	glm::mat4 model;
+	glm::vec4 color;
+	b2World* world;
+	b2Body* body;
+	unsigned int VBO;
+	unsigned int numVertices;
+	glm::vec2 vertices[6];
+	b2Vec2 previousPosition;
+	float previousAngle;
+};
+
+// Spawns, snapshots and removes count shapes through the scene store and
+// through a vector of individually allocated objects. Both see the same
+// bodies; only the bookkeeping around them is timed.
+void benchStore(int count)
+{
+	const int iterations = 100;
+
+	b2World benchWorld(b2Vec2(0.0f, 0.0f));
+	std::vector<b2Body*> bodies(count);
+	for (int i = 0; i < count; i++)
+	{
+		b2BodyDef bodyDef;
+		bodyDef.position.Set((float)(i % 100), (float)(i / 100));
+		bodies[i] = benchWorld.CreateBody(&bodyDef);
+	}
+
+	std::vector<int> removeOrder(count);
+	for (int i = 0; i < count; i++) removeOrder[i] = i;
+	std::shuffle(removeOrder.begin(), removeOrder.end(), std::default_random_engine(1));
+
+	std::vector<BodySnapshot> out;
+	b2Timer timer;
+
+	// Pointer vector
+	std::vector<PointerShape*> pointers;
+
+	timer.Reset();
+	for (int i = 0; i < count; i++)
+	{
+		PointerShape* shape = new PointerShape();
+		shape->body = bodies[i];
+		shape->world = &benchWorld;
+		shape->color = glm::vec4(1.0f);
+		shape->numVertices = 6;
+		pointers.push_back(shape);
+	}
+	float pointerSpawn = timer.GetMilliseconds();
+
+	timer.Reset();
+	for (int n = 0; n < iterations; n++)
+	{
+		out.resize(pointers.size());
+		for (size_t i = 0; i < pointers.size(); i++)
+		{
+			const PointerShape* shape = pointers[i];
+			out[i].previousPosition = box2DToWorld(shape->previousPosition);
+			out[i].position = box2DToWorld(shape->body->GetPosition());
+			out[i].previousAngle = shape->previousAngle;
+			out[i].angle = shape->body->GetAngle();
+			out[i].geometry = RectangleGeometry;
+			out[i].size = shape->vertices[1];
+			out[i].color = shape->color;
+		}
+	}
+	float pointerIterate = timer.GetMilliseconds() / iterations;
+
+	timer.Reset();
+	for (int i = 0; i < count; i++)
+	{
+		b2Body* body = bodies[removeOrder[i]];
+		for (size_t j = 0; j < pointers.size(); j++)
+		{
+			if (pointers[j]->body == body)
+			{
+				delete pointers[j];
+				pointers.erase(pointers.begin() + j);
+				break;
+			}
+		}
+	}
+	float pointerRemove = timer.GetMilliseconds();
+
+	// Scene store
+	Scene store;
+	std::vector<ShapeHandle> handles(count);
+
+	timer.Reset();
+	for (int i = 0; i < count; i++)
+	{
+		handles[i] = store.add(bodies[i], RectangleGeometry, glm::vec2(1.0f), glm::vec4(1.0f), 0.0f);
+	}
+	float storeSpawn = timer.GetMilliseconds();
+
+	timer.Reset();
+	for (int n = 0; n < iterations; n++)
+	{
+		store.snapshot(out);
+	}
+	float storeIterate = timer.GetMilliseconds() / iterations;
+
+	timer.Reset();
+	for (int i = 0; i < count; i++)
+	{
+		store.remove(handles[removeOrder[i]]);
+	}
+	float storeRemove = timer.GetMilliseconds();
+
+	printf("%d shapes          spawn ms   snapshot ms   remove ms\n", count);
+	printf("pointer vector   %9.3f   %11.3f   %9.3f\n", pointerSpawn, pointerIterate, pointerRemove);
+	printf("scene store      %9.3f   %11.3f   %9.3f\n", storeSpawn, storeIterate, storeRemove);
+}
+
+// Steps a world of separate box piles, each its own island, with every
+// thread count from 1 to maxThreads, and checks that all end in the same
+// state as the single threaded run. Islands and the narrow phase both
+// spread over the threads.
+void benchIslands(int piles, int maxThreads)
+{
+	const int height = 8;
+	const int steps = 300;
+
+	unsigned long long reference = 0;
+	float referenceStep = 0.0f;
+
+	printf("%d piles of %d boxes, %d steps\n", piles, height, steps);
+	printf("threads   step ms   collide ms   solve ms   speedup   state\n");
+
+	for (int threads = 1; threads <= maxThreads; threads++)
+	{
+		b2World benchWorld(b2Vec2(0.0f, -10.0f));
+		benchWorld.SetAllowSleeping(false);
+		benchWorld.SetThreadCount(threads);
+
+		b2BodyDef groundDef;
+		b2Body* ground = benchWorld.CreateBody(&groundDef);
+		b2EdgeShape edge;
+		edge.Set(b2Vec2(-2.0f, 0.0f), b2Vec2(piles * 3.0f, 0.0f));
+		ground->CreateFixture(&edge, 0.0f);
+
+		b2PolygonShape box;
+		box.SetAsBox(0.5f, 0.5f);
+
+		for (int i = 0; i < piles; i++)
+		{
+			for (int j = 0; j < height; j++)
+			{
+				b2BodyDef bodyDef;
+				bodyDef.type = b2_dynamicBody;
+				bodyDef.position.Set(i * 3.0f + 0.05f * (j % 3), 0.5f + j * 1.01f);
+				benchWorld.CreateBody(&bodyDef)->CreateFixture(&box, 1.0f);
+			}
+		}
+
+		float step = 0.0f;
+		float collide = 0.0f;
+		float solve = 0.0f;
+
+		for (int n = 0; n < steps; n++)
+		{
+			benchWorld.Step(1.0f / 60.0f, 8, 3);
+			step += benchWorld.GetProfile().step;
+			collide += benchWorld.GetProfile().collide;
+			solve += benchWorld.GetProfile().solve;
+		}
+
+		unsigned long long state = hashBytes(nullptr, 0);
+		for (b2Body* body = benchWorld.GetBodyList(); body; body = body->GetNext())
+		{
+			b2Transform transform = body->GetTransform();
+			state = hashBytes(&transform, sizeof(transform), state);
+		}
+
+		if (threads == 1)
+		{
+			reference = state;
+			referenceStep = step;
+		}
+
+		printf("%7d   %7.3f   %10.3f   %8.3f   %6.2fx   %016llx%s\n", threads, step / steps, collide / steps, solve / steps,
+			referenceStep / step, state, state == reference ? "" : " differs");
+	}
+}
+
+// Steps one pyramid of boxes, a single island, uncolored on one thread,
+// graph colored on one thread with contacts solved one by one, and then
+// colored on wide batches with every thread count from 1 to maxThreads.
+// Checks that the colored runs all end in the same state.
+void benchPile(int base, int maxThreads)
+{
+	const int steps = 300;
+
+	unsigned long long reference = 0;
+	float referenceStep = 0.0f;
+	b2Profile colors = {};
+
+	printf("pyramid of %d boxes, %d steps\n", base * (base + 1) / 2, steps);
+	printf("threads    solver   step ms   solve ms   velocity ms   position ms   speedup   colors   state\n");
+
+	for (int run = 0; run <= maxThreads + 1; run++)
+	{
+		bool colored = run > 0;
+		bool wide = run > 1;
+		int threads = std::max(run - 1, 1);
+
+		b2World benchWorld(b2Vec2(0.0f, -10.0f));
+		benchWorld.SetAllowSleeping(false);
+		benchWorld.SetThreadCount(threads);
+		benchWorld.SetGraphColoring(colored);
+		benchWorld.SetWideSolve(wide);
+
+		b2BodyDef groundDef;
+		b2Body* ground = benchWorld.CreateBody(&groundDef);
+		b2EdgeShape edge;
+		edge.Set(b2Vec2(-base * 2.0f, 0.0f), b2Vec2(base * 2.0f, 0.0f));
+		ground->CreateFixture(&edge, 0.0f);
+
+		b2PolygonShape box;
+		box.SetAsBox(0.5f, 0.5f);
+
+		// Rows shift by half a box, so every box rests on two below it.
+		b2Vec2 row(-base * 0.5625f, 0.75f);
+		for (int i = 0; i < base; i++)
+		{
+			b2Vec2 position = row;
+			for (int j = i; j < base; j++)
+			{
+				b2BodyDef bodyDef;
+				bodyDef.type = b2_dynamicBody;
+				bodyDef.position = position;
+				benchWorld.CreateBody(&bodyDef)->CreateFixture(&box, 5.0f);
+				position += b2Vec2(1.125f, 0.0f);
+			}
+			row += b2Vec2(0.5625f, 1.0f);
+		}
+
+		float step = 0.0f;
+		float solve = 0.0f;
+		float velocity = 0.0f;
+		float position = 0.0f;
+
+		for (int n = 0; n < steps; n++)
+		{
+			benchWorld.Step(1.0f / 60.0f, 8, 3);
+			step += benchWorld.GetProfile().step;
+			solve += benchWorld.GetProfile().solve;
+			velocity += benchWorld.GetProfile().solveVelocity;
+			position += benchWorld.GetProfile().solvePosition;
+		}
+
+		unsigned long long state = hashBytes(nullptr, 0);
+		for (b2Body* body = benchWorld.GetBodyList(); body; body = body->GetNext())
+		{
+			b2Transform transform = body->GetTransform();
+			state = hashBytes(&transform, sizeof(transform), state);
+		}
+
+		if (run == 0) referenceStep = step;
+		if (run == 1)
+		{
+			reference = state;
+			colors = benchWorld.GetProfile();
+		}
+
+		printf("%7d   %7s   %7.3f   %8.3f   %11.3f   %11.3f   %6.2fx   %6d   %016llx%s\n", threads, wide ? "wide" : (colored ? "colored" : "plain"),
+			step / steps, solve / steps, velocity / steps, position / steps, referenceStep / step,
+			benchWorld.GetProfile().colorCount, state, colored && state != reference ? " differs" : "");
+	}
+
+	printf("constraints per color:");
+	for (int i = 0; i < colors.colorCount; i++) printf(" %d", colors.colorSizes[i]);
+	printf(", overflow %d\n", colors.colorOverflow);
+}
+
+// One fixed step of the scene curve.
+struct StepSample
+{
+	b2Profile profile;
+	unsigned int bodies;
+	unsigned int contacts;
+};
+
+std::vector<StepSample> stepSamples;
+
+void collectStep(const b2Profile& profile)
+{
+	StepSample sample = { profile, dynamicCount(), (unsigned int)world.GetContactCount() };
+	stepSamples.push_back(sample);
+}
+
+float percentile(std::vector<float> values, float fraction)
+{
+	if (values.empty()) return 0.0f;
+
+	size_t n = (size_t)(fraction * (values.size() - 1) + 0.5f);
+	std::nth_element(values.begin(), values.begin() + n, values.end());
+	return values[n];
+}
+
+// Body count at which the median step over a one second window first
+// exceeds the step budget, or 0 if it never does.
+unsigned int budgetBrokenAt(float budget, size_t window)
+{
+	std::vector<float> times;
+
+	for (size_t i = window; i <= stepSamples.size(); i++)
+	{
+		times.clear();
+		for (size_t j = i - window; j < i; j++) times.push_back(stepSamples[j].profile.step);
+
+		if (percentile(times, 0.5f) > budget) return stepSamples[i - 1].bodies;
+	}
+
+	return 0;
+}
+
+void writeProfileJson(FILE* file, float budget, unsigned int brokenAt, float p50, float p99, float maximum)
+{
+	fprintf(file, "{\n\t\"physics_rate\": %g,\n\t\"spawn_rate\": %g,\n\t\"budget_ms\": %g,\n\t\"steps\": [\n", 1.0f / step, spawnRate, budget);
+
+	for (size_t i = 0; i < stepSamples.size(); i++)
+	{
+		const StepSample& sample = stepSamples[i];
+		const b2Profile& profile = sample.profile;
+
+		fprintf(file, "\t\t{ \"bodies\": %u, \"contacts\": %u, \"step\": %.4f, \"collide\": %.4f, \"solve\": %.4f, "
+			"\"solveInit\": %.4f, \"solveVelocity\": %.4f, \"solvePosition\": %.4f, \"broadphase\": %.4f, \"solveTOI\": %.4f, \"colors\": [",
+			sample.bodies, sample.contacts, profile.step, profile.collide, profile.solve,
+			profile.solveInit, profile.solveVelocity, profile.solvePosition, profile.broadphase, profile.solveTOI);
+
+		// Constraints per graph color, empty when no island was colored.
+		for (int j = 0; j < profile.colorCount; j++)
+		{
+			fprintf(file, "%s%d", j ? ", " : "", profile.colorSizes[j]);
+		}
+
+		fprintf(file, "], \"colorOverflow\": %d }%s\n", profile.colorOverflow, i + 1 < stepSamples.size() ? "," : "");
+	}
+
+	fprintf(file, "\t],\n\t\"summary\": { \"steps\": %u, \"p50\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"budget_broken_at\": %u }\n}\n",
+		(unsigned int)stepSamples.size(), p50, p99, maximum, brokenAt);
+}
+
+// Stands in for the display's clock so the frame pacer sees the frame
+// loop's simulated, jittered frame times.
+std::atomic<long long> displayNanoseconds(0);
+
+long long displayClock()
+{
+	return displayNanoseconds.load();
+}
+
+// Applies recorded events up to the next frame and returns its time in
+// time, or false at the end of the log. Spawns recorded for the frames so
+// far are added to expectedSpawns.
+bool replayFrame(long long& time, unsigned int& expectedSpawns)
+{
+	SessionEvent event;
+	long long value = 0;
+	float x = 0.0f, y = 0.0f;
+
+	while (sessionLog.next(event, value, x, y))
+	{
+		switch (event)
+		{
+		case FrameEvent:
+			time = value;
+			return true;
+		case SpawnEvent:
+			expectedSpawns += (unsigned int)value;
+			break;
+		case LevelEvent:
+			stepController.force((int)value);
+			break;
+		case TouchEvent:
+			queueInput((InputType)value, x, y);
+			break;
+		case ResizeEvent:
+			initGraphics((int)x, (int)y);
+			break;
+		}
+	}
+
+	return false;
+}
+
+// Drives the same init/step sequence the Java side does, at full speed with
+// a simulated display clock, and reports CPU cost and GL calls per frame.
+//
+// AntRoitHeadless [--frames N] [--width W] [--height H]
+//                 [--physics-rate HZ] [--render-rate HZ]
+//                 [--population-cap N] [--retire oldest|sleeping|offscreen]
+//                 [--cache-dir DIR] [--surface-loss FRAMES]
+//                 [--spawn-rate PER_SECOND] [--shape-size PX] [--profile-json FILE]
+//                 [--step-budget MS] [--record FILE] [--replay FILE]
+//                 [--telemetry 0|1] [--touch-interval FRAMES] [--overdraw 0|1]
+//                 [--pacer 0|1] [--frame-jitter MS] [--threaded-physics 0|1]
+//                 [--physics-threads N] [--graph-coloring 0|1]
+//                 [--bench-islands PILES] [--bench-pile BASE]
+//                 [--bench-store COUNT]
+int main(int argc, char** argv)
+{
+	int frames = 3600;
+	int width = 1280;
+	int height = 720;
+	float physicsRate = 60.0f;
+	float renderRate = 60.0f;
+	int benchStoreCount = 0;
+	int benchIslandPiles = 0;
+	int benchPileBase = 0;
+	int physicsThreads = 1;
+	bool graphColoring = false;
+	int surfaceLoss = 0;
+	const char* replayPath = nullptr;
+	bool printTelemetry = false;
+	int touchInterval = 0;
+	bool pacing = true;
+	float frameJitter = 0.0f;
+	bool threaded = false;
+	const char* profilePath = nullptr;
+	float stepBudget = stepController.budget;
+	int cap = populationCap;
+	RetirementPolicy policy = retirementPolicy;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (!strcmp(argv[i], "--frames")) frames = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--width")) width = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--height")) height = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--physics-rate")) physicsRate = (float)atof(argv[i + 1]);
+		else if (!strcmp(argv[i], "--render-rate")) renderRate = (float)atof(argv[i + 1]);
+		else if (!strcmp(argv[i], "--bench-store")) benchStoreCount = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--bench-islands")) benchIslandPiles = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--bench-pile")) benchPileBase = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--physics-threads")) physicsThreads = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--graph-coloring")) graphColoring = atoi(argv[i + 1]) != 0;
+		else if (!strcmp(argv[i], "--population-cap")) cap = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--cache-dir")) programCacheDirectory = argv[i + 1];
+		else if (!strcmp(argv[i], "--surface-loss")) surfaceLoss = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--spawn-rate")) spawnRate = (float)atof(argv[i + 1]);
+		else if (!strcmp(argv[i], "--shape-size")) shapeSize = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--record")) sessionRecordPath = argv[i + 1];
+		else if (!strcmp(argv[i], "--replay")) replayPath = argv[i + 1];
+		else if (!strcmp(argv[i], "--telemetry")) printTelemetry = atoi(argv[i + 1]) != 0;
+		else if (!strcmp(argv[i], "--touch-interval")) touchInterval = atoi(argv[i + 1]);
+		else if (!strcmp(argv[i], "--pacer")) pacing = atoi(argv[i + 1]) != 0;
+		else if (!strcmp(argv[i], "--frame-jitter")) frameJitter = (float)atof(argv[i + 1]);
+		else if (!strcmp(argv[i], "--threaded-physics")) threaded = atoi(argv[i + 1]) != 0;
+		else if (!strcmp(argv[i], "--overdraw")) recorder.estimateOverdraw = atoi(argv[i + 1]) != 0;
+		else if (!strcmp(argv[i], "--profile-json")) profilePath = argv[i + 1];
+		else if (!strcmp(argv[i], "--step-budget")) stepBudget = (float)atof(argv[i + 1]);
+		else if (!strcmp(argv[i], "--retire") && !strcmp(argv[i + 1], "oldest")) policy = RetireOldest;
+		else if (!strcmp(argv[i], "--retire") && !strcmp(argv[i + 1], "sleeping")) policy = RetireSleepingLongest;
+		else if (!strcmp(argv[i], "--retire") && !strcmp(argv[i + 1], "offscreen")) policy = RetireOffScreen;
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[i]);
+			return 1;
+		}
+	}
+
+	if (benchIslandPiles > 0)
+	{
+		benchIslands(benchIslandPiles, std::max(physicsThreads, 1));
+		return 0;
+	}
+
+	if (benchPileBase > 0)
+	{
+		benchPile(benchPileBase, std::max(physicsThreads, 1));
+		return 0;
+	}
+
+	if (benchStoreCount > 0)
+	{
+		benchStore(benchStoreCount);
+		return 0;
+	}
+
+	if (replayPath)
+	{
+		SessionHeader header;
+		if (!sessionLog.startReplay(replayPath, header))
+		{
+			fprintf(stderr, "Could not replay %s\n", replayPath);
+			return 1;
+		}
+
+		width = header.width;
+		height = header.height;
+		surfaceLoss = 0;
+		printf("replaying %s: seed %u, %dx%d\n", replayPath, header.seed, width, height);
+	}
+	else
+	{
+		setPhysicsRate(physicsRate);
+		setPopulation(cap, policy);
+		setStepBudget(stepBudget);
+		setGraphColoring(graphColoring);
+	}
+
+	setPhysicsThreads(physicsThreads);
+
+	// Replays feed update() their recorded times, so they stay on this thread.
+	threadedPhysics = threaded && !replayPath;
+
+	b2Timer startup;
+	initGraphics(width, height);
+	printf("startup: %.3f ms, program %s in %.3f ms\n", startup.GetMilliseconds(),
+		programFromCache ? "from binary cache" : "compiled", programLoadMilliseconds);
+	recorder.reset();
+
+	stepObserver = collectStep;
+	framePacer.clock = displayClock;
+	std::mt19937 jitterGenerator(1);
+
+	double updateSeconds = 0.0;
+	double drawSeconds = 0.0;
+	unsigned long long commands = 0;
+	unsigned long long drawCalls = 0;
+	unsigned long long bytesUploaded = 0;
+	OverdrawStats overdraw = {};
+	int surfaces = 0;
+	double surfaceSeconds = 0.0;
+	int modeFrames[SteppingModeCount] = {};
+	int idleFrames = 0;
+	int substepFrames[3] = {};
+	unsigned int expectedSpawns = 0;
+	int divergedAt = -1;
+
+	b2Timer timer;
+
+	for (int frame = 0; replayPath || frame < frames; frame++)
+	{
+		// Frames start on the display's vsyncs plus scheduling jitter.
+		displayNanoseconds = (long long)(frame * 1e9 / renderRate);
+		if (frameJitter > 0.0f) displayNanoseconds += (long long)(RandomFloat(-frameJitter, frameJitter)(jitterGenerator) * 1e6f);
+
+		long long time = pacing ? framePacer.frame() : displayNanoseconds.load();
+
+		if (replayPath)
+		{
+			bool more = replayFrame(time, expectedSpawns);
+
+			if (divergedAt < 0 && expectedSpawns != spawnCount) divergedAt = frame - 1;
+
+			if (!more)
+			{
+				frames = frame;
+				break;
+			}
+		}
+
+		// Recreate the surface like a rotation or resume would, swapping
+		// the orientation each time.
+		if (surfaceLoss > 0 && frame > 0 && frame % surfaceLoss == 0)
+		{
+			std::swap(width, height);
+
+			timer.Reset();
+			initGraphics(width, height);
+			surfaceSeconds += timer.GetMilliseconds() / 1000.0;
+			surfaces++;
+		}
+
+		// Drags from the middle of the screen in a circle for half of
+		// each interval, with four moves per frame like a 240 Hz panel.
+		if (!replayPath && touchInterval > 0)
+		{
+			int gesture = frame % touchInterval;
+			float radius = std::min(width, height) / 4.0f;
+
+			if (gesture == 0)
+			{
+				queueInput(TouchDown, width / 2.0f, height / 2.0f);
+			}
+			else if (gesture < touchInterval / 2)
+			{
+				for (int move = 0; move < 4; move++)
+				{
+					float angle = (gesture * 4 + move) * 0.02f;
+					queueInput(TouchMove, width / 2.0f + radius * sinf(angle), height / 2.0f + radius * (1.0f - cosf(angle)));
+				}
+			}
+			else if (gesture == touchInterval / 2)
+			{
+				queueInput(TouchUp, width / 2.0f, height / 2.0f);
+			}
+		}
+
+		if (threadedPhysics)
+		{
+			// As the device does: draw the snapshot stepped to this frame's
+			// present, then let the simulation thread step to the next one.
+			// Waiting for it keeps the simulated display in lockstep.
+			timer.Reset();
+			drawTime = time;
+			draw();
+			drawSeconds += timer.GetMilliseconds() / 1000.0;
+
+			timer.Reset();
+			long long next = time + framePacer.period;
+			pacePhysics(next);
+			while (simulatedTime.load() < next) std::this_thread::yield();
+			updateSeconds += timer.GetMilliseconds() / 1000.0;
+			modeFrames[stepController.mode()]++;
+			substepFrames[std::min(simulatedSubsteps.exchange(0), 2)]++;
+			if (quiescent.load() && inputQueue.empty()) idleFrames++;
+		}
+		else
+		{
+			timer.Reset();
+			update(time);
+			publishSnapshot();
+			updateSeconds += timer.GetMilliseconds() / 1000.0;
+			modeFrames[stepController.mode()]++;
+			substepFrames[std::min(updateStats.substeps, 2)]++;
+			if (quiescent.load() && inputQueue.empty()) idleFrames++;
+
+			timer.Reset();
+			draw();
+			drawSeconds += timer.GetMilliseconds() / 1000.0;
+		}
+
+		commands += recorder.commands.size();
+		drawCalls += recorder.stats.drawCalls;
+		bytesUploaded += recorder.stats.bytesUploaded;
+		overdraw.shaded += recorder.overdraw.shaded;
+		overdraw.covered += recorder.overdraw.covered;
+		overdraw.pixels += recorder.overdraw.pixels;
+
+		recorder.reset();
+	}
+
+	stopSimulation();
+	sessionLog.stop();
+
+	if (printTelemetry) printf("telemetry: %s\n", telemetrySnapshot().c_str());
+
+	if (replayPath)
+	{
+		if (divergedAt >= 0) printf("replay diverged at frame %d: %u spawns, %u recorded\n", divergedAt, spawnCount, expectedSpawns);
+		else printf("replay matched: %u spawns\n", spawnCount);
+	}
+
+	if (frames > 0)
+	{
+		printf("%d frames, %u shapes, %u pooled bodies\n", frames, (unsigned int)scene.size(), (unsigned int)bodyPool.size());
+
+		// Equal across a recording and its replay when they ran identically.
+		unsigned long long state = hashBytes(nullptr, 0);
+		for (auto body : scene.bodies)
+		{
+			b2Transform transform = body->GetTransform();
+			state = hashBytes(&transform, sizeof(transform), state);
+		}
+		printf("world state: %016llx\n", state);
+		printf("update: %.3f ms/frame\n", updateSeconds * 1000.0 / frames);
+		printf("draw: %.3f ms/frame\n", drawSeconds * 1000.0 / frames);
+		printf("commands: %.1f/frame, draw calls: %.1f/frame, uploaded: %.0f bytes/frame\n",
+			(double)commands / frames, (double)drawCalls / frames, (double)bytesUploaded / frames);
+
+		printf("stepping:");
+		for (int mode = 0; mode < SteppingModeCount; mode++)
+		{
+			printf(" %s %.1f%%%s", steppingModeName((SteppingMode)mode), modeFrames[mode] * 100.0 / frames, mode + 1 < SteppingModeCount ? "," : "\n");
+		}
+
+		printf("idle: %.1f%% of frames\n", idleFrames * 100.0 / frames);
+		printf("substeps per frame: %d with 0, %d with 1, %d with 2 or more\n", substepFrames[0], substepFrames[1], substepFrames[2]);
+		if (pacing) printf("frame pacer: %.3f ms refresh period\n", framePacer.period / 1e6);
+
+		if (overdraw.pixels > 0.0)
+		{
+			printf("overdraw: %.3f fragments shaded per pixel, %.3f without depth rejection\n",
+				overdraw.shaded / overdraw.pixels, overdraw.covered / overdraw.pixels);
+		}
+
+		if (surfaces > 0)
+		{
+			printf("surface recreation: %d times, %.3f ms each\n", surfaces, surfaceSeconds * 1000.0 / surfaces);
+		}
 	}
 
-	JNIEXPORT void JNICALL Java_fi_enko_antroit_AntRoitLib_touch(JNIEnv* env, jobject obj, jfloat x, jfloat y)
+	if (!stepSamples.empty())
 	{
-		touch(x, y);
+		std::vector<float> times;
+		for (const auto& sample : stepSamples) times.push_back(sample.profile.step);
+
+		float budget = step * 1000.0f;
+		float p50 = percentile(times, 0.5f);
+		float p99 = percentile(times, 0.99f);
+		float maximum = *std::max_element(times.begin(), times.end());
+		unsigned int brokenAt = budgetBrokenAt(budget, (size_t)(1.0f / step + 0.5f));
+
+		printf("step: p50 %.3f ms, p99 %.3f ms, max %.3f ms over %u steps\n", p50, p99, maximum, (unsigned int)stepSamples.size());
+		if (brokenAt) printf("step budget %.3f ms broken at %u bodies\n", budget, brokenAt);
+		else printf("step budget %.3f ms held up to %u bodies\n", budget, stepSamples.back().bodies);
+
+		if (profilePath)
+		{
+			FILE* file = fopen(profilePath, "w");
+			if (file)
+			{
+				writeProfileJson(file, budget, brokenAt, p50, p99, maximum);
+				fclose(file);
+			}
+			else
+			{
+				fprintf(stderr, "Could not write %s\n", profilePath);
+			}
+		}
 	}
+
+	clearShapes();
+
+	return 0;
 }
 
-#pragma endregion
\ No newline at end of file
+#pragma endregion
+
+#endif
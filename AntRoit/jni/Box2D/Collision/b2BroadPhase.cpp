@@ -17,6 +17,140 @@
 */
 
 #include <Box2D/Collision/b2BroadPhase.h>
+#include <Box2D/Common/b2TaskScheduler.h>
+#include <algorithm>
+
+static void b2PushPair(b2PairBuffer* buffer, int32 proxyIdA, int32 proxyIdB)
+{
+	if (buffer->count == buffer->capacity)
+	{
+		b2Pair* oldPairs = buffer->pairs;
+		buffer->capacity = b2Max(2 * buffer->capacity, 16);
+		buffer->pairs = (b2Pair*)b2Alloc(buffer->capacity * sizeof(b2Pair));
+		if (oldPairs)
+		{
+			memcpy(buffer->pairs, oldPairs, buffer->count * sizeof(b2Pair));
+			b2Free(oldPairs);
+		}
+	}
+
+	buffer->pairs[buffer->count].proxyIdA = proxyIdA;
+	buffer->pairs[buffer->count].proxyIdB = proxyIdB;
+	++buffer->count;
+}
+
+// Tree query callback for one thread. The tree is only read.
+struct b2PairQuery
+{
+	bool QueryCallback(int32 proxyId)
+	{
+		if (proxyId != queryProxyId)
+		{
+			b2PushPair(buffer, b2Min(proxyId, queryProxyId), b2Max(proxyId, queryProxyId));
+		}
+		return true;
+	}
+
+	int32 queryProxyId;
+	b2PairBuffer* buffer;
+};
+
+// Queries one batch of moved proxies into the buffer of the running thread.
+class b2PairQueryTask : public b2Task
+{
+public:
+	void Execute(int32 index, int32 threadIndex)
+	{
+		b2PairQuery query;
+		query.buffer = buffers + threadIndex;
+
+		int32 begin = index * b2_pairBatchSize;
+		int32 end = b2Min(begin + b2_pairBatchSize, moveCount);
+		for (int32 i = begin; i < end; ++i)
+		{
+			query.queryProxyId = moveBuffer[i];
+			if (query.queryProxyId == b2BroadPhase::e_nullProxy)
+			{
+				continue;
+			}
+
+			tree->Query(&query, tree->GetFatAABB(query.queryProxyId));
+		}
+	}
+
+	const b2DynamicTree* tree;
+	const int32* moveBuffer;
+	int32 moveCount;
+	b2PairBuffer* buffers;
+};
+
+class b2PairSortTask : public b2Task
+{
+public:
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+		b2PairBuffer* buffer = buffers + index;
+		std::sort(buffer->pairs, buffer->pairs + buffer->count, b2PairLessThan);
+	}
+
+	b2PairBuffer* buffers;
+};
+
+// Merges the pairs with proxyIdA in [index * span, (index + 1) * span) from
+// every sorted thread buffer into one sorted range without duplicates.
+class b2PairMergeTask : public b2Task
+{
+public:
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+		b2Pair lower = { index * span, -1 };
+		b2Pair upper = { (index + 1) * span, -1 };
+
+		const b2Pair** heads = cursors + 2 * index * bufferCount;
+		const b2Pair** ends = heads + bufferCount;
+		for (int32 i = 0; i < bufferCount; ++i)
+		{
+			const b2Pair* first = buffers[i].pairs;
+			const b2Pair* last = first + buffers[i].count;
+			heads[i] = std::lower_bound(first, last, lower, b2PairLessThan);
+			ends[i] = std::lower_bound(heads[i], last, upper, b2PairLessThan);
+		}
+
+		b2PairBuffer* range = ranges + index;
+		range->count = 0;
+		for (;;)
+		{
+			int32 next = -1;
+			for (int32 i = 0; i < bufferCount; ++i)
+			{
+				if (heads[i] != ends[i] && (next == -1 || b2PairLessThan(*heads[i], *heads[next])))
+				{
+					next = i;
+				}
+			}
+
+			if (next == -1)
+			{
+				break;
+			}
+
+			const b2Pair* pair = heads[next]++;
+			if (range->count == 0 || pair->proxyIdA != range->pairs[range->count - 1].proxyIdA ||
+				pair->proxyIdB != range->pairs[range->count - 1].proxyIdB)
+			{
+				b2PushPair(range, pair->proxyIdA, pair->proxyIdB);
+			}
+		}
+	}
+
+	const b2PairBuffer* buffers;
+	int32 bufferCount;
+	int32 span;
+	b2PairBuffer* ranges;
+	const b2Pair** cursors;
+};
 
 b2BroadPhase::b2BroadPhase()
 {
@@ -29,14 +163,32 @@ b2BroadPhase::b2BroadPhase()
 	m_moveCapacity = 16;
 	m_moveCount = 0;
 	m_moveBuffer = (int32*)b2Alloc(m_moveCapacity * sizeof(int32));
+
+	m_taskScheduler = NULL;
+	m_threadPairs = NULL;
+	m_rangePairs = NULL;
+	m_mergeCursors = NULL;
+	m_pairBufferCount = 0;
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
+	for (int32 i = 0; i < 2 * m_pairBufferCount; ++i)
+	{
+		b2Free(m_threadPairs[i].pairs);
+	}
+	b2Free(m_threadPairs);
+	b2Free(m_mergeCursors);
+
 	b2Free(m_moveBuffer);
 	b2Free(m_pairBuffer);
 }
 
+void b2BroadPhase::SetTaskScheduler(b2TaskScheduler* scheduler)
+{
+	m_taskScheduler = scheduler;
+}
+
 int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 {
 	int32 proxyId = m_tree.CreateProxy(aabb, userData);
@@ -117,3 +269,71 @@ bool b2BroadPhase::QueryCallback(int32 proxyId)
 
 	return true;
 }
+
+int32 b2BroadPhase::FindPairsParallel()
+{
+	int32 threadCount = m_taskScheduler ? m_taskScheduler->GetThreadCount() : 1;
+	if (threadCount <= 1 || m_moveCount < 2 * b2_pairBatchSize)
+	{
+		return 0;
+	}
+
+	// One block holds the thread buffers followed by the range buffers.
+	if (m_pairBufferCount < threadCount)
+	{
+		b2PairBuffer* buffers = (b2PairBuffer*)b2Alloc(2 * threadCount * sizeof(b2PairBuffer));
+		memset(buffers, 0, 2 * threadCount * sizeof(b2PairBuffer));
+		for (int32 i = 0; i < m_pairBufferCount; ++i)
+		{
+			buffers[i] = m_threadPairs[i];
+			buffers[threadCount + i] = m_rangePairs[i];
+		}
+		b2Free(m_threadPairs);
+		b2Free(m_mergeCursors);
+
+		m_threadPairs = buffers;
+		m_rangePairs = buffers + threadCount;
+		m_mergeCursors = (const b2Pair**)b2Alloc(2 * threadCount * threadCount * sizeof(const b2Pair*));
+		m_pairBufferCount = threadCount;
+	}
+
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		m_threadPairs[i].count = 0;
+	}
+
+	// Thread buffers hold unordered pairs, possibly repeated across buffers.
+	b2PairQueryTask query;
+	query.tree = &m_tree;
+	query.moveBuffer = m_moveBuffer;
+	query.moveCount = m_moveCount;
+	query.buffers = m_threadPairs;
+	m_taskScheduler->ParallelFor(&query, (m_moveCount + b2_pairBatchSize - 1) / b2_pairBatchSize);
+
+	b2PairSortTask sort;
+	sort.buffers = m_threadPairs;
+	m_taskScheduler->ParallelFor(&sort, threadCount);
+
+	// Split the proxyIdA space evenly so each range merges independently.
+	// Ranges are merged in order, so the result matches the serial sort.
+	int32 maxProxyId = -1;
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		if (m_threadPairs[i].count > 0)
+		{
+			maxProxyId = b2Max(maxProxyId, m_threadPairs[i].pairs[m_threadPairs[i].count - 1].proxyIdA);
+		}
+	}
+
+	b2PairMergeTask merge;
+	merge.buffers = m_threadPairs;
+	merge.bufferCount = threadCount;
+	merge.span = (maxProxyId + threadCount) / threadCount;
+	merge.ranges = m_rangePairs;
+	merge.cursors = m_mergeCursors;
+	m_taskScheduler->ParallelFor(&merge, threadCount);
+
+	m_moveCount = 0;
+
+	return threadCount;
+}
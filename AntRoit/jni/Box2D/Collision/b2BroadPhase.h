@@ -24,12 +24,22 @@
 #include <Box2D/Collision/b2DynamicTree.h>
 #include <algorithm>
 
+class b2TaskScheduler;
+
 struct b2Pair
 {
 	int32 proxyIdA;
 	int32 proxyIdB;
 };
 
+/// Growable pair storage used when pairs are found on several threads.
+struct b2PairBuffer
+{
+	b2Pair* pairs;
+	int32 count;
+	int32 capacity;
+};
+
 /// The broad-phase is used for computing pairs and performing volume queries and ray casts.
 /// This broad-phase does not persist pairs. Instead, this reports potentially new pairs.
 /// It is up to the client to consume the new pairs and to track subsequent overlap.
@@ -72,9 +82,14 @@ public:
 	int32 GetProxyCount() const;
 
 	/// Update the pairs. This results in pair callbacks. This can only add pairs.
+	/// Pairs are reported sorted by proxy id, however many threads found them.
 	template <typename T>
 	void UpdatePairs(T* callback);
 
+	/// Find pairs on this scheduler when it has more than one thread and
+	/// enough proxies moved. NULL finds them on the calling thread.
+	void SetTaskScheduler(b2TaskScheduler* scheduler);
+
 	/// Query an AABB for overlapping proxies. The callback class
 	/// is called for each proxy that overlaps the supplied AABB.
 	template <typename T>
@@ -113,6 +128,12 @@ private:
 
 	bool QueryCallback(int32 proxyId);
 
+	// Queries the moved proxies concurrently into per thread buffers,
+	// sorts each buffer, then merges and dedupes ranges of proxyIdA
+	// concurrently into m_rangePairs. Returns the range count, or 0 if
+	// the pairs should be found serially.
+	int32 FindPairsParallel();
+
 	b2DynamicTree m_tree;
 
 	int32 m_proxyCount;
@@ -126,6 +147,15 @@ private:
 	int32 m_pairCount;
 
 	int32 m_queryProxyId;
+
+	b2TaskScheduler* m_taskScheduler;
+
+	// Per thread query results, then per range merge results, and each
+	// range's cursors into every thread's results.
+	b2PairBuffer* m_threadPairs;
+	b2PairBuffer* m_rangePairs;
+	const b2Pair** m_mergeCursors;
+	int32 m_pairBufferCount;
 };
 
 /// This is used to sort pairs.
@@ -184,6 +214,22 @@ inline float32 b2BroadPhase::GetTreeQuality() const
 template <typename T>
 void b2BroadPhase::UpdatePairs(T* callback)
 {
+	int32 rangeCount = FindPairsParallel();
+	if (rangeCount > 0)
+	{
+		for (int32 r = 0; r < rangeCount; ++r)
+		{
+			const b2PairBuffer& range = m_rangePairs[r];
+			for (int32 i = 0; i < range.count; ++i)
+			{
+				void* userDataA = m_tree.GetUserData(range.pairs[i].proxyIdA);
+				void* userDataB = m_tree.GetUserData(range.pairs[i].proxyIdB);
+				callback->AddPair(userDataA, userDataB);
+			}
+		}
+		return;
+	}
+
 	// Reset pair buffer
 	m_pairCount = 0;
 
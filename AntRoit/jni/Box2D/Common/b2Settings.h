@@ -85,6 +85,23 @@ typedef double float64;
 /// Maximum number of contacts to be handled to solve a TOI impact.
 #define b2_maxTOIContacts			32
 
+/// Contacts per task when the narrow phase runs on several threads.
+#define b2_collideBatchSize			64
+
+/// Moved proxies per task when the broad-phase finds pairs on several threads.
+#define b2_pairBatchSize			64
+
+/// Contacts and joints an island needs before it is graph colored, when the
+/// world has graph coloring enabled.
+#define b2_graphColorMinConstraints	256
+
+/// Colors an island's constraints are spread over, at most 32. Constraints that
+/// fit in none are solved on the calling thread after the colors.
+#define b2_graphColorCount			24
+
+/// Constraints per task when one graph color is solved on several threads.
+#define b2_colorBatchSize			32
+
 /// A velocity threshold for elastic collisions. Any collision with a relative linear
 /// velocity below this threshold will be treated as inelastic.
 #define b2_velocityThreshold		1.0f
@@ -0,0 +1,141 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2TaskScheduler.h>
+
+b2ThreadPool::b2ThreadPool(int32 threadCount)
+{
+	m_task = NULL;
+	m_count = 0;
+	m_next = 0;
+	m_busy = 0;
+	m_batch = 0;
+	m_stopping = false;
+
+	Start(threadCount);
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	Stop();
+}
+
+void b2ThreadPool::SetThreadCount(int32 threadCount)
+{
+	if (threadCount == GetThreadCount())
+	{
+		return;
+	}
+
+	Stop();
+	Start(threadCount);
+}
+
+int32 b2ThreadPool::GetThreadCount() const
+{
+	return (int32)m_workers.size() + 1;
+}
+
+void b2ThreadPool::Start(int32 threadCount)
+{
+	m_stopping = false;
+	for (int32 i = 1; i < threadCount; ++i)
+	{
+		m_workers.push_back(std::thread(&b2ThreadPool::Work, this, i, m_batch));
+	}
+}
+
+void b2ThreadPool::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); ++i)
+	{
+		m_workers[i].join();
+	}
+	m_workers.clear();
+}
+
+void b2ThreadPool::ParallelFor(b2Task* task, int32 count)
+{
+	if (m_workers.empty() || count <= 1)
+	{
+		for (int32 i = 0; i < count; ++i)
+		{
+			task->Execute(i, 0);
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = task;
+		m_count = count;
+		m_next = 0;
+		m_busy = (int32)m_workers.size();
+		++m_batch;
+	}
+	m_wake.notify_all();
+
+	Run(0);
+
+	// Workers may still be finishing their last item.
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_done.wait(lock, [this] { return m_busy == 0; });
+	m_task = NULL;
+}
+
+// Starts from the batch count at creation, so a worker never runs a batch
+// that finished before it existed.
+void b2ThreadPool::Work(int32 threadIndex, uint32 batch)
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stopping || m_batch != batch; });
+
+			if (m_stopping)
+			{
+				return;
+			}
+
+			batch = m_batch;
+		}
+
+		Run(threadIndex);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (--m_busy == 0)
+		{
+			m_done.notify_one();
+		}
+	}
+}
+
+void b2ThreadPool::Run(int32 threadIndex)
+{
+	for (int32 i = m_next++; i < m_count; i = m_next++)
+	{
+		m_task->Execute(i, threadIndex);
+	}
+}
@@ -0,0 +1,91 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TASK_SCHEDULER_H
+#define B2_TASK_SCHEDULER_H
+
+#include <Box2D/Common/b2Settings.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// A batch of independent work items run by a task scheduler.
+class b2Task
+{
+public:
+	virtual ~b2Task() {}
+
+	/// Run one item. The thread index is below the scheduler's thread count
+	/// and is the same for every item run by the same thread, so it can
+	/// select per thread scratch memory.
+	virtual void Execute(int32 index, int32 threadIndex) = 0;
+};
+
+/// Implement this to run the world's parallel work on your own job system.
+/// The world only calls it from within b2World::Step.
+class b2TaskScheduler
+{
+public:
+	virtual ~b2TaskScheduler() {}
+
+	/// The number of threads that may run items, including the caller.
+	virtual int32 GetThreadCount() const = 0;
+
+	/// Run task items 0 to count - 1 in any order and on any of the
+	/// threads, and return once all of them have finished.
+	virtual void ParallelFor(b2Task* task, int32 count) = 0;
+};
+
+/// The default scheduler: the calling thread plus threadCount - 1 workers
+/// that sleep between batches. Items are handed out one at a time.
+class b2ThreadPool : public b2TaskScheduler
+{
+public:
+	explicit b2ThreadPool(int32 threadCount = 1);
+	~b2ThreadPool();
+
+	/// Stop the workers and start threadCount - 1 new ones.
+	void SetThreadCount(int32 threadCount);
+
+	int32 GetThreadCount() const;
+	void ParallelFor(b2Task* task, int32 count);
+
+private:
+
+	void Start(int32 threadCount);
+	void Stop();
+	void Work(int32 threadIndex, uint32 batch);
+	void Run(int32 threadIndex);
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+
+	b2Task* m_task;
+	int32 m_count;
+	std::atomic<int32> m_next;
+	int32 m_busy;
+	uint32 m_batch;
+	bool m_stopping;
+};
+
+#endif
@@ -189,6 +189,14 @@ protected:
 
 	void Update(b2ContactListener* listener);
 
+	// Update in two halves for the parallel narrow phase. UpdateManifold
+	// only writes to this contact, so contacts can run it concurrently; it
+	// keeps the previous manifold in oldManifold and returns whether the
+	// contact was touching. ReportUpdate then re-enables the contact, wakes
+	// the bodies and calls the listener as Update would have.
+	bool UpdateManifold(b2Manifold* oldManifold);
+	void ReportUpdate(b2ContactListener* listener, const b2Manifold& oldManifold, bool wasTouching);
+
 	static b2ContactRegister s_registers[b2Shape::e_typeCount][b2Shape::e_typeCount];
 	static bool s_initialized;
 
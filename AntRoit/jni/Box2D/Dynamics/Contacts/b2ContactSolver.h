@@ -64,6 +64,10 @@ struct b2ContactSolverDef
 	b2Position* positions;
 	b2Velocity* velocities;
 	b2StackAllocator* allocator;
+
+	// Island indices of each contact's bodies as pairs, or NULL to read
+	// them from the bodies.
+	const int32* indices;
 };
 
 class b2ContactSolver
@@ -81,6 +85,12 @@ public:
 	bool SolvePositionConstraints();
 	bool SolveTOIPositionConstraints(int32 toiIndexA, int32 toiIndexB);
 
+	/// The same over the listed constraints only, for solving graph colors
+	/// concurrently. Returns the minimum separation instead of a verdict.
+	void WarmStart(const int32* indices, int32 count);
+	void SolveVelocityConstraints(const int32* indices, int32 count);
+	float32 SolvePositionConstraints(const int32* indices, int32 count);
+
 	b2TimeStep m_step;
 	b2Position* m_positions;
 	b2Velocity* m_velocities;
@@ -89,6 +99,11 @@ public:
 	b2ContactVelocityConstraint* m_velocityConstraints;
 	b2Contact** m_contacts;
 	int m_count;
+
+private:
+	void WarmStartConstraint(b2ContactVelocityConstraint* vc);
+	void SolveVelocityConstraint(b2ContactVelocityConstraint* vc);
+	float32 SolvePositionConstraint(b2ContactPositionConstraint* pc);
 };
 
 #endif
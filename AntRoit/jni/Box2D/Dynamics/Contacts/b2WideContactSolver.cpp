@@ -0,0 +1,424 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/Contacts/b2WideContactSolver.h>
+#include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__AVX2__) && !defined(B2_NO_SIMD)
+
+static inline b2FloatW b2SplatW(float32 s) { return _mm256_set1_ps(s); }
+static inline b2FloatW b2LoadW(const float32* p) { return _mm256_loadu_ps(p); }
+static inline void b2StoreW(float32* p, b2FloatW a) { _mm256_storeu_ps(p, a); }
+static inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm256_add_ps(a, b); }
+static inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm256_sub_ps(a, b); }
+static inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm256_mul_ps(a, b); }
+static inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm256_min_ps(a, b); }
+static inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm256_max_ps(a, b); }
+static inline b2FloatW b2NegW(b2FloatW a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+static inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm256_and_ps(a, b); }
+static inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return _mm256_or_ps(a, b); }
+static inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { return _mm256_blendv_ps(b, a, mask); }
+
+#elif (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && !defined(B2_NO_SIMD)
+
+static inline b2FloatW b2SplatW(float32 s) { return _mm_set1_ps(s); }
+static inline b2FloatW b2LoadW(const float32* p) { return _mm_loadu_ps(p); }
+static inline void b2StoreW(float32* p, b2FloatW a) { _mm_storeu_ps(p, a); }
+static inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { return _mm_add_ps(a, b); }
+static inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { return _mm_sub_ps(a, b); }
+static inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { return _mm_mul_ps(a, b); }
+static inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { return _mm_min_ps(a, b); }
+static inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { return _mm_max_ps(a, b); }
+static inline b2FloatW b2NegW(b2FloatW a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+static inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { return _mm_cmpge_ps(a, b); }
+static inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { return _mm_and_ps(a, b); }
+static inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { return _mm_or_ps(a, b); }
+static inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+
+#else
+
+// Masks hold 1 in true lanes and 0 in false ones.
+#define b2_forLanes(i) for (int32 i = 0; i < b2_simdWidth; ++i)
+
+static inline b2FloatW b2SplatW(float32 s) { b2FloatW r; b2_forLanes(i) r.lanes[i] = s; return r; }
+static inline b2FloatW b2LoadW(const float32* p) { b2FloatW r; b2_forLanes(i) r.lanes[i] = p[i]; return r; }
+static inline void b2StoreW(float32* p, b2FloatW a) { b2_forLanes(i) p[i] = a.lanes[i]; }
+static inline b2FloatW b2AddW(b2FloatW a, b2FloatW b) { b2_forLanes(i) a.lanes[i] = a.lanes[i] + b.lanes[i]; return a; }
+static inline b2FloatW b2SubW(b2FloatW a, b2FloatW b) { b2_forLanes(i) a.lanes[i] = a.lanes[i] - b.lanes[i]; return a; }
+static inline b2FloatW b2MulW(b2FloatW a, b2FloatW b) { b2_forLanes(i) a.lanes[i] = a.lanes[i] * b.lanes[i]; return a; }
+static inline b2FloatW b2MinW(b2FloatW a, b2FloatW b) { b2_forLanes(i) a.lanes[i] = b2Min(a.lanes[i], b.lanes[i]); return a; }
+static inline b2FloatW b2MaxW(b2FloatW a, b2FloatW b) { b2_forLanes(i) a.lanes[i] = b2Max(a.lanes[i], b.lanes[i]); return a; }
+static inline b2FloatW b2NegW(b2FloatW a) { b2_forLanes(i) a.lanes[i] = -a.lanes[i]; return a; }
+static inline b2FloatW b2GreaterEqualW(b2FloatW a, b2FloatW b) { b2_forLanes(i) a.lanes[i] = a.lanes[i] >= b.lanes[i] ? 1.0f : 0.0f; return a; }
+static inline b2FloatW b2AndW(b2FloatW a, b2FloatW b) { b2_forLanes(i) a.lanes[i] = a.lanes[i] != 0.0f && b.lanes[i] != 0.0f ? 1.0f : 0.0f; return a; }
+static inline b2FloatW b2OrW(b2FloatW a, b2FloatW b) { b2_forLanes(i) a.lanes[i] = a.lanes[i] != 0.0f || b.lanes[i] != 0.0f ? 1.0f : 0.0f; return a; }
+static inline b2FloatW b2SelectW(b2FloatW mask, b2FloatW a, b2FloatW b) { b2_forLanes(i) a.lanes[i] = mask.lanes[i] != 0.0f ? a.lanes[i] : b.lanes[i]; return a; }
+
+#undef b2_forLanes
+
+#endif
+
+// Constraints are packed into lanes one float at a time through memory.
+static inline void b2SetLane(b2FloatW* w, int32 lane, float32 value)
+{
+	memcpy((char*)w + lane * sizeof(float32), &value, sizeof(float32));
+}
+
+// The velocities of each lane's bodies.
+struct b2WideBodies
+{
+	b2FloatW vAx, vAy, wA;
+	b2FloatW vBx, vBy, wB;
+};
+
+static inline void b2GatherBodies(b2WideBodies* bodies, const b2WideContact* wc, const b2Velocity* velocities)
+{
+	float32 vAx[b2_simdWidth], vAy[b2_simdWidth], wA[b2_simdWidth];
+	float32 vBx[b2_simdWidth], vBy[b2_simdWidth], wB[b2_simdWidth];
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		const b2Velocity& a = velocities[wc->indexA[i]];
+		const b2Velocity& b = velocities[wc->indexB[i]];
+		vAx[i] = a.v.x;
+		vAy[i] = a.v.y;
+		wA[i] = a.w;
+		vBx[i] = b.v.x;
+		vBy[i] = b.v.y;
+		wB[i] = b.w;
+	}
+
+	bodies->vAx = b2LoadW(vAx);
+	bodies->vAy = b2LoadW(vAy);
+	bodies->wA = b2LoadW(wA);
+	bodies->vBx = b2LoadW(vBx);
+	bodies->vBy = b2LoadW(vBy);
+	bodies->wB = b2LoadW(wB);
+}
+
+// Bodies without mass are left as they were, as in b2ContactSolver.
+static inline void b2ScatterBodies(const b2WideBodies* bodies, const b2WideContact* wc, b2Velocity* velocities)
+{
+	float32 vAx[b2_simdWidth], vAy[b2_simdWidth], wA[b2_simdWidth];
+	float32 vBx[b2_simdWidth], vBy[b2_simdWidth], wB[b2_simdWidth];
+	float32 mA[b2_simdWidth], iA[b2_simdWidth], mB[b2_simdWidth], iB[b2_simdWidth];
+	b2StoreW(vAx, bodies->vAx);
+	b2StoreW(vAy, bodies->vAy);
+	b2StoreW(wA, bodies->wA);
+	b2StoreW(vBx, bodies->vBx);
+	b2StoreW(vBy, bodies->vBy);
+	b2StoreW(wB, bodies->wB);
+	b2StoreW(mA, wc->invMassA);
+	b2StoreW(iA, wc->invIA);
+	b2StoreW(mB, wc->invMassB);
+	b2StoreW(iB, wc->invIB);
+
+	for (int32 i = 0; i < b2_simdWidth; ++i)
+	{
+		if (mA[i] != 0.0f || iA[i] != 0.0f)
+		{
+			b2Velocity& a = velocities[wc->indexA[i]];
+			a.v.Set(vAx[i], vAy[i]);
+			a.w = wA[i];
+		}
+
+		if (mB[i] != 0.0f || iB[i] != 0.0f)
+		{
+			b2Velocity& b = velocities[wc->indexB[i]];
+			b.v.Set(vBx[i], vBy[i]);
+			b.w = wB[i];
+		}
+	}
+}
+
+// vB + b2Cross(wB, rB) - vA - b2Cross(wA, rA), evaluated in that order.
+static inline void b2RelativeVelocity(const b2WideBodies& b, const b2WideContactPoint& cp, b2FloatW* dvx, b2FloatW* dvy)
+{
+	*dvx = b2SubW(b2SubW(b2AddW(b.vBx, b2MulW(b2NegW(b.wB), cp.rBy)), b.vAx), b2MulW(b2NegW(b.wA), cp.rAy));
+	*dvy = b2SubW(b2SubW(b2AddW(b.vBy, b2MulW(b.wB, cp.rBx)), b.vAy), b2MulW(b.wA, cp.rAx));
+}
+
+// b2Cross(r, P).
+static inline b2FloatW b2CrossW(b2FloatW rx, b2FloatW ry, b2FloatW px, b2FloatW py)
+{
+	return b2SubW(b2MulW(rx, py), b2MulW(ry, px));
+}
+
+// Apply the impulse P at one point: A loses it and B gains it.
+static inline void b2ApplyImpulse(b2WideBodies* b, const b2WideContact* wc, const b2WideContactPoint& cp, b2FloatW px, b2FloatW py)
+{
+	b->vAx = b2SubW(b->vAx, b2MulW(wc->invMassA, px));
+	b->vAy = b2SubW(b->vAy, b2MulW(wc->invMassA, py));
+	b->wA = b2SubW(b->wA, b2MulW(wc->invIA, b2CrossW(cp.rAx, cp.rAy, px, py)));
+	b->vBx = b2AddW(b->vBx, b2MulW(wc->invMassB, px));
+	b->vBy = b2AddW(b->vBy, b2MulW(wc->invMassB, py));
+	b->wB = b2AddW(b->wB, b2MulW(wc->invIB, b2CrossW(cp.rBx, cp.rBy, px, py)));
+}
+
+b2WideContactSolver::b2WideContactSolver(b2ContactVelocityConstraint* constraints, int32 count,
+										b2Velocity* velocities, b2StackAllocator* allocator)
+{
+	m_constraints = constraints;
+	m_velocities = velocities;
+	m_allocator = allocator;
+	m_count = count;
+
+	// Stack allocations are not aligned for b2FloatW, so align by hand.
+	const uintptr_t alignment = 32;
+	m_memory = m_allocator->Allocate(m_count * sizeof(b2WideContact) + alignment);
+	m_contacts = (b2WideContact*)(((uintptr_t)m_memory + alignment - 1) & ~(alignment - 1));
+}
+
+b2WideContactSolver::~b2WideContactSolver()
+{
+	m_allocator->Free(m_memory);
+}
+
+void b2WideContactSolver::Pack(int32 batch, const int32* indices)
+{
+	b2WideContact* wc = m_contacts + batch;
+	memset(wc, 0, sizeof(b2WideContact));
+	wc->pointCount = m_constraints[indices[0]].pointCount;
+
+	for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+	{
+		int32 index = indices[lane];
+		const b2ContactVelocityConstraint* vc = m_constraints + index;
+		b2Assert(vc->pointCount == wc->pointCount);
+
+		wc->constraints[lane] = index;
+		wc->indexA[lane] = vc->indexA;
+		wc->indexB[lane] = vc->indexB;
+
+		b2SetLane(&wc->normalX, lane, vc->normal.x);
+		b2SetLane(&wc->normalY, lane, vc->normal.y);
+		b2SetLane(&wc->invMassA, lane, vc->invMassA);
+		b2SetLane(&wc->invIA, lane, vc->invIA);
+		b2SetLane(&wc->invMassB, lane, vc->invMassB);
+		b2SetLane(&wc->invIB, lane, vc->invIB);
+		b2SetLane(&wc->friction, lane, vc->friction);
+		b2SetLane(&wc->tangentSpeed, lane, vc->tangentSpeed);
+
+		for (int32 j = 0; j < vc->pointCount; ++j)
+		{
+			const b2VelocityConstraintPoint* vcp = vc->points + j;
+			b2WideContactPoint* cp = wc->points + j;
+			b2SetLane(&cp->rAx, lane, vcp->rA.x);
+			b2SetLane(&cp->rAy, lane, vcp->rA.y);
+			b2SetLane(&cp->rBx, lane, vcp->rB.x);
+			b2SetLane(&cp->rBy, lane, vcp->rB.y);
+			b2SetLane(&cp->normalImpulse, lane, vcp->normalImpulse);
+			b2SetLane(&cp->tangentImpulse, lane, vcp->tangentImpulse);
+			b2SetLane(&cp->normalMass, lane, vcp->normalMass);
+			b2SetLane(&cp->tangentMass, lane, vcp->tangentMass);
+			b2SetLane(&cp->velocityBias, lane, vcp->velocityBias);
+		}
+
+		if (vc->pointCount == 2)
+		{
+			b2SetLane(&wc->k11, lane, vc->K.ex.x);
+			b2SetLane(&wc->k21, lane, vc->K.ex.y);
+			b2SetLane(&wc->k12, lane, vc->K.ey.x);
+			b2SetLane(&wc->k22, lane, vc->K.ey.y);
+			b2SetLane(&wc->m11, lane, vc->normalMass.ex.x);
+			b2SetLane(&wc->m21, lane, vc->normalMass.ex.y);
+			b2SetLane(&wc->m12, lane, vc->normalMass.ey.x);
+			b2SetLane(&wc->m22, lane, vc->normalMass.ey.y);
+		}
+	}
+}
+
+void b2WideContactSolver::WarmStart(int32 begin, int32 end)
+{
+	for (int32 i = begin; i < end; ++i)
+	{
+		const b2WideContact* wc = m_contacts + i;
+
+		b2WideBodies bodies;
+		b2GatherBodies(&bodies, wc, m_velocities);
+
+		// tangent = b2Cross(normal, 1.0f)
+		b2FloatW tangentX = wc->normalY;
+		b2FloatW tangentY = b2NegW(wc->normalX);
+
+		for (int32 j = 0; j < wc->pointCount; ++j)
+		{
+			const b2WideContactPoint& cp = wc->points[j];
+			b2FloatW px = b2AddW(b2MulW(cp.normalImpulse, wc->normalX), b2MulW(cp.tangentImpulse, tangentX));
+			b2FloatW py = b2AddW(b2MulW(cp.normalImpulse, wc->normalY), b2MulW(cp.tangentImpulse, tangentY));
+			b2ApplyImpulse(&bodies, wc, cp, px, py);
+		}
+
+		b2ScatterBodies(&bodies, wc, m_velocities);
+	}
+}
+
+void b2WideContactSolver::SolveVelocityConstraints(int32 begin, int32 end)
+{
+	const b2FloatW zero = b2SplatW(0.0f);
+
+	for (int32 i = begin; i < end; ++i)
+	{
+		b2WideContact* wc = m_contacts + i;
+
+		b2WideBodies bodies;
+		b2GatherBodies(&bodies, wc, m_velocities);
+
+		b2FloatW normalX = wc->normalX;
+		b2FloatW normalY = wc->normalY;
+		b2FloatW tangentX = normalY;
+		b2FloatW tangentY = b2NegW(normalX);
+
+		// Solve tangent constraints first because non-penetration is more important
+		// than friction.
+		for (int32 j = 0; j < wc->pointCount; ++j)
+		{
+			b2WideContactPoint& cp = wc->points[j];
+
+			b2FloatW dvx, dvy;
+			b2RelativeVelocity(bodies, cp, &dvx, &dvy);
+
+			b2FloatW vt = b2SubW(b2AddW(b2MulW(dvx, tangentX), b2MulW(dvy, tangentY)), wc->tangentSpeed);
+			b2FloatW lambda = b2MulW(cp.tangentMass, b2NegW(vt));
+
+			b2FloatW maxFriction = b2MulW(wc->friction, cp.normalImpulse);
+			b2FloatW newImpulse = b2MaxW(b2NegW(maxFriction), b2MinW(b2AddW(cp.tangentImpulse, lambda), maxFriction));
+			lambda = b2SubW(newImpulse, cp.tangentImpulse);
+			cp.tangentImpulse = newImpulse;
+
+			b2ApplyImpulse(&bodies, wc, cp, b2MulW(lambda, tangentX), b2MulW(lambda, tangentY));
+		}
+
+		if (wc->pointCount == 1)
+		{
+			b2WideContactPoint& cp = wc->points[0];
+
+			b2FloatW dvx, dvy;
+			b2RelativeVelocity(bodies, cp, &dvx, &dvy);
+
+			b2FloatW vn = b2AddW(b2MulW(dvx, normalX), b2MulW(dvy, normalY));
+			b2FloatW lambda = b2MulW(b2NegW(cp.normalMass), b2SubW(vn, cp.velocityBias));
+
+			b2FloatW newImpulse = b2MaxW(b2AddW(cp.normalImpulse, lambda), zero);
+			lambda = b2SubW(newImpulse, cp.normalImpulse);
+			cp.normalImpulse = newImpulse;
+
+			b2ApplyImpulse(&bodies, wc, cp, b2MulW(lambda, normalX), b2MulW(lambda, normalY));
+		}
+		else
+		{
+			// The block solver of b2ContactSolver::SolveVelocityConstraint,
+			// with all four cases evaluated and the first that holds picked
+			// per lane. Lanes where none holds are left alone.
+			b2WideContactPoint& cp1 = wc->points[0];
+			b2WideContactPoint& cp2 = wc->points[1];
+
+			b2FloatW ax = cp1.normalImpulse;
+			b2FloatW ay = cp2.normalImpulse;
+
+			b2FloatW dv1x, dv1y, dv2x, dv2y;
+			b2RelativeVelocity(bodies, cp1, &dv1x, &dv1y);
+			b2RelativeVelocity(bodies, cp2, &dv2x, &dv2y);
+
+			b2FloatW vn1 = b2AddW(b2MulW(dv1x, normalX), b2MulW(dv1y, normalY));
+			b2FloatW vn2 = b2AddW(b2MulW(dv2x, normalX), b2MulW(dv2y, normalY));
+
+			// b = vn - velocityBias - K * a
+			b2FloatW bx = b2SubW(vn1, cp1.velocityBias);
+			b2FloatW by = b2SubW(vn2, cp2.velocityBias);
+			bx = b2SubW(bx, b2AddW(b2MulW(wc->k11, ax), b2MulW(wc->k12, ay)));
+			by = b2SubW(by, b2AddW(b2MulW(wc->k21, ax), b2MulW(wc->k22, ay)));
+
+			// Case 1: x = - inv(K) * b
+			b2FloatW x1x = b2NegW(b2AddW(b2MulW(wc->m11, bx), b2MulW(wc->m12, by)));
+			b2FloatW x1y = b2NegW(b2AddW(b2MulW(wc->m21, bx), b2MulW(wc->m22, by)));
+			b2FloatW case1 = b2AndW(b2GreaterEqualW(x1x, zero), b2GreaterEqualW(x1y, zero));
+
+			// Case 2: x1 = - b1 / a11, x2 = 0
+			b2FloatW x2x = b2MulW(b2NegW(cp1.normalMass), bx);
+			b2FloatW case2vn2 = b2AddW(b2MulW(wc->k21, x2x), by);
+			b2FloatW case2 = b2AndW(b2GreaterEqualW(x2x, zero), b2GreaterEqualW(case2vn2, zero));
+
+			// Case 3: x1 = 0, x2 = - b2 / a22
+			b2FloatW x3y = b2MulW(b2NegW(cp2.normalMass), by);
+			b2FloatW case3vn1 = b2AddW(b2MulW(wc->k12, x3y), bx);
+			b2FloatW case3 = b2AndW(b2GreaterEqualW(x3y, zero), b2GreaterEqualW(case3vn1, zero));
+
+			// Case 4: x1 = 0, x2 = 0
+			b2FloatW case4 = b2AndW(b2GreaterEqualW(bx, zero), b2GreaterEqualW(by, zero));
+
+			b2FloatW xx = b2SelectW(case1, x1x, b2SelectW(case2, x2x, zero));
+			b2FloatW xy = b2SelectW(case1, x1y, b2SelectW(case2, zero, b2SelectW(case3, x3y, zero)));
+			b2FloatW solved = b2OrW(b2OrW(case1, case2), b2OrW(case3, case4));
+
+			b2FloatW dx = b2SubW(xx, ax);
+			b2FloatW dy = b2SubW(xy, ay);
+			b2FloatW p1x = b2MulW(dx, normalX);
+			b2FloatW p1y = b2MulW(dx, normalY);
+			b2FloatW p2x = b2MulW(dy, normalX);
+			b2FloatW p2y = b2MulW(dy, normalY);
+
+			b2WideBodies solvedBodies;
+			solvedBodies.vAx = b2SubW(bodies.vAx, b2MulW(wc->invMassA, b2AddW(p1x, p2x)));
+			solvedBodies.vAy = b2SubW(bodies.vAy, b2MulW(wc->invMassA, b2AddW(p1y, p2y)));
+			solvedBodies.wA = b2SubW(bodies.wA, b2MulW(wc->invIA, b2AddW(b2CrossW(cp1.rAx, cp1.rAy, p1x, p1y), b2CrossW(cp2.rAx, cp2.rAy, p2x, p2y))));
+			solvedBodies.vBx = b2AddW(bodies.vBx, b2MulW(wc->invMassB, b2AddW(p1x, p2x)));
+			solvedBodies.vBy = b2AddW(bodies.vBy, b2MulW(wc->invMassB, b2AddW(p1y, p2y)));
+			solvedBodies.wB = b2AddW(bodies.wB, b2MulW(wc->invIB, b2AddW(b2CrossW(cp1.rBx, cp1.rBy, p1x, p1y), b2CrossW(cp2.rBx, cp2.rBy, p2x, p2y))));
+
+			bodies.vAx = b2SelectW(solved, solvedBodies.vAx, bodies.vAx);
+			bodies.vAy = b2SelectW(solved, solvedBodies.vAy, bodies.vAy);
+			bodies.wA = b2SelectW(solved, solvedBodies.wA, bodies.wA);
+			bodies.vBx = b2SelectW(solved, solvedBodies.vBx, bodies.vBx);
+			bodies.vBy = b2SelectW(solved, solvedBodies.vBy, bodies.vBy);
+			bodies.wB = b2SelectW(solved, solvedBodies.wB, bodies.wB);
+
+			cp1.normalImpulse = b2SelectW(solved, xx, ax);
+			cp2.normalImpulse = b2SelectW(solved, xy, ay);
+		}
+
+		b2ScatterBodies(&bodies, wc, m_velocities);
+	}
+}
+
+void b2WideContactSolver::StoreImpulses(int32 begin, int32 end)
+{
+	for (int32 i = begin; i < end; ++i)
+	{
+		const b2WideContact* wc = m_contacts + i;
+
+		for (int32 j = 0; j < wc->pointCount; ++j)
+		{
+			float32 normalImpulses[b2_simdWidth];
+			float32 tangentImpulses[b2_simdWidth];
+			b2StoreW(normalImpulses, wc->points[j].normalImpulse);
+			b2StoreW(tangentImpulses, wc->points[j].tangentImpulse);
+
+			for (int32 lane = 0; lane < b2_simdWidth; ++lane)
+			{
+				b2VelocityConstraintPoint* vcp = m_constraints[wc->constraints[lane]].points + j;
+				vcp->normalImpulse = normalImpulses[lane];
+				vcp->tangentImpulse = tangentImpulses[lane];
+			}
+		}
+	}
+}
@@ -0,0 +1,113 @@
+/*
+* Copyright (c) 2006-2009 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_WIDE_CONTACT_SOLVER_H
+#define B2_WIDE_CONTACT_SOLVER_H
+
+#include <Box2D/Common/b2Settings.h>
+
+// One float per lane. AVX2 builds get 8 lanes and SSE2 builds 4. Other
+// targets, or builds defining B2_NO_SIMD, run 4 lanes of plain floats,
+// which are no faster than solving contacts one by one, so b2_simdVector
+// is 0 there and the wide path is off by default.
+#if defined(__AVX2__) && !defined(B2_NO_SIMD)
+#include <immintrin.h>
+typedef __m256 b2FloatW;
+#define b2_simdWidth		8
+#define b2_simdVector		1
+#elif (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)) && !defined(B2_NO_SIMD)
+#include <emmintrin.h>
+typedef __m128 b2FloatW;
+#define b2_simdWidth		4
+#define b2_simdVector		1
+#else
+struct b2FloatW { float32 lanes[4]; };
+#define b2_simdWidth		4
+#define b2_simdVector		0
+#endif
+
+class b2StackAllocator;
+struct b2ContactVelocityConstraint;
+struct b2Velocity;
+
+/// One point of b2_simdWidth contacts, a contact per lane.
+struct b2WideContactPoint
+{
+	b2FloatW rAx, rAy;
+	b2FloatW rBx, rBy;
+	b2FloatW normalImpulse;
+	b2FloatW tangentImpulse;
+	b2FloatW normalMass;
+	b2FloatW tangentMass;
+	b2FloatW velocityBias;
+};
+
+/// b2_simdWidth contacts with the same point count, as structure of arrays.
+struct b2WideContact
+{
+	b2WideContactPoint points[b2_maxManifoldPoints];
+	b2FloatW normalX, normalY;
+	b2FloatW invMassA, invIA;
+	b2FloatW invMassB, invIB;
+	b2FloatW friction;
+	b2FloatW tangentSpeed;
+
+	// The block solver's K and its inverse by row and column.
+	b2FloatW k11, k12, k21, k22;
+	b2FloatW m11, m12, m21, m22;
+
+	int32 indexA[b2_simdWidth];
+	int32 indexB[b2_simdWidth];
+	int32 constraints[b2_simdWidth];
+	int32 pointCount;
+};
+
+/// Solves the velocity constraints of contacts b2_simdWidth at a time, one
+/// per lane, including the two point block solver. Every operation matches
+/// b2ContactSolver's, so results are the same bit for bit unless the
+/// compiler contracts multiply-adds differently in the two.
+class b2WideContactSolver
+{
+public:
+	/// Room for count batches, each filled by Pack.
+	b2WideContactSolver(b2ContactVelocityConstraint* constraints, int32 count,
+						b2Velocity* velocities, b2StackAllocator* allocator);
+	~b2WideContactSolver();
+
+	/// Pack b2_simdWidth velocity constraints into one batch. They must
+	/// share one point count and write no body twice.
+	void Pack(int32 batch, const int32* indices);
+
+	/// Batches begin to end - 1 only.
+	void WarmStart(int32 begin, int32 end);
+	void SolveVelocityConstraints(int32 begin, int32 end);
+
+	/// Copy the accumulated impulses back to the velocity constraints.
+	void StoreImpulses(int32 begin, int32 end);
+
+	b2WideContact* m_contacts;
+	int32 m_count;
+
+private:
+	b2ContactVelocityConstraint* m_constraints;
+	b2Velocity* m_velocities;
+	b2StackAllocator* m_allocator;
+	void* m_memory;
+};
+
+#endif
@@ -389,6 +389,7 @@ private:
 	friend class b2Island;
 	friend class b2ContactManager;
 	friend class b2ContactSolver;
+	friend class b2ConstraintGraph;
 	friend class b2Contact;
 	
 	friend class b2DistanceJoint;
@@ -0,0 +1,386 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Dynamics/b2ConstraintGraph.h>
+#include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <Box2D/Dynamics/Contacts/b2WideContactSolver.h>
+#include <Box2D/Dynamics/Joints/b2Joint.h>
+#include <Box2D/Common/b2StackAllocator.h>
+
+#include <new>
+#include <string.h>
+
+extern bool g_blockSolve;
+
+// Wide batches per task, about b2_colorBatchSize contacts.
+#define b2_wideTaskSize		b2Max(b2_colorBatchSize / b2_simdWidth, 1)
+
+// The lowest color not in the used mask, or b2_graphColorCount for none.
+static int32 b2FreeColor(uint32 used)
+{
+	for (int32 i = 0; i < b2_graphColorCount; ++i)
+	{
+		if ((used & (1u << i)) == 0)
+		{
+			return i;
+		}
+	}
+
+	return b2_graphColorCount;
+}
+
+b2ConstraintGraph::b2ConstraintGraph(b2ContactSolver* contactSolver, b2Joint** joints, int32 jointCount, int32 bodyCount,
+									const b2SolverData& data, b2TaskScheduler* scheduler, bool wideSolve, b2StackAllocator* allocator)
+{
+	b2Assert(b2_graphColorCount <= 32);
+
+	m_contactSolver = contactSolver;
+	m_joints = joints;
+	m_data = data;
+	m_scheduler = scheduler;
+	m_allocator = allocator;
+
+	int32 contactCount = contactSolver->m_count;
+	int32 count = jointCount + contactCount;
+
+	m_threadCount = scheduler->GetThreadCount();
+	m_constraints = (int32*)m_allocator->Allocate(count * sizeof(int32));
+	m_minSeparations = (float32*)m_allocator->Allocate(m_threadCount * sizeof(float32));
+	m_jointsOkay = (bool*)m_allocator->Allocate(m_threadCount * sizeof(bool));
+
+	// Per body masks of the colors writing it and of those only reading it.
+	int32* colors = (int32*)m_allocator->Allocate(count * sizeof(int32));
+	uint32* written = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	uint32* read = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	memset(written, 0, bodyCount * sizeof(uint32));
+	memset(read, 0, bodyCount * sizeof(uint32));
+
+	int32 sizes[b2_graphColorCount + 1];
+	memset(sizes, 0, sizeof(sizes));
+
+	for (int32 i = 0; i < jointCount; ++i)
+	{
+		int32 indexA = joints[i]->m_bodyA->m_islandIndex;
+		int32 indexB = joints[i]->m_bodyB->m_islandIndex;
+
+		int32 color = b2FreeColor(written[indexA] | read[indexA] | written[indexB] | read[indexB]);
+		if (color < b2_graphColorCount)
+		{
+			written[indexA] |= 1u << color;
+			written[indexB] |= 1u << color;
+		}
+
+		colors[i] = color;
+		++sizes[color];
+	}
+
+	for (int32 i = 0; i < contactCount; ++i)
+	{
+		const b2ContactVelocityConstraint* vc = contactSolver->m_velocityConstraints + i;
+		int32 indexA = vc->indexA;
+		int32 indexB = vc->indexB;
+		bool writesA = vc->invMassA != 0.0f || vc->invIA != 0.0f;
+		bool writesB = vc->invMassB != 0.0f || vc->invIB != 0.0f;
+
+		uint32 used = written[indexA] | written[indexB];
+		if (writesA)
+		{
+			used |= read[indexA];
+		}
+		if (writesB)
+		{
+			used |= read[indexB];
+		}
+
+		int32 color = b2FreeColor(used);
+		if (color < b2_graphColorCount)
+		{
+			uint32 bit = 1u << color;
+			(writesA ? written : read)[indexA] |= bit;
+			(writesB ? written : read)[indexB] |= bit;
+		}
+
+		colors[jointCount + i] = color;
+		++sizes[color];
+	}
+
+	m_colorCount = 0;
+	m_colorStarts[0] = 0;
+	for (int32 i = 0; i <= b2_graphColorCount; ++i)
+	{
+		m_colorStarts[i + 1] = m_colorStarts[i] + sizes[i];
+		if (i < b2_graphColorCount && sizes[i] > 0)
+		{
+			m_colorCount = i + 1;
+		}
+	}
+
+	// Joints come before contacts, so each color lists its joints first.
+	int32 cursors[b2_graphColorCount + 1];
+	memcpy(cursors, m_colorStarts, sizeof(cursors));
+	for (int32 i = 0; i < count; ++i)
+	{
+		m_constraints[cursors[colors[i]]++] = i < jointCount ? -1 - i : i - jointCount;
+	}
+
+	m_colorWide[0] = 0;
+	for (int32 i = 0; i < m_colorCount; ++i)
+	{
+		Order(i, wideSolve, colors);
+	}
+
+	m_allocator->Free(read);
+	m_allocator->Free(written);
+	m_allocator->Free(colors);
+
+	m_wideSolver = NULL;
+	int32 batchCount = m_colorWide[m_colorCount];
+	if (batchCount > 0)
+	{
+		void* mem = m_allocator->Allocate(sizeof(b2WideContactSolver));
+		m_wideSolver = new (mem) b2WideContactSolver(contactSolver->m_velocityConstraints, batchCount,
+													 m_data.velocities, m_allocator);
+
+		for (int32 i = 0; i < m_colorCount; ++i)
+		{
+			const int32* contacts = m_constraints + m_colorContacts[i];
+			for (int32 j = m_colorWide[i]; j < m_colorWide[i + 1]; ++j)
+			{
+				m_wideSolver->Pack(j, contacts + (j - m_colorWide[i]) * b2_simdWidth);
+			}
+		}
+	}
+}
+
+b2ConstraintGraph::~b2ConstraintGraph()
+{
+	if (m_wideSolver)
+	{
+		m_wideSolver->~b2WideContactSolver();
+		m_allocator->Free(m_wideSolver);
+	}
+
+	m_allocator->Free(m_jointsOkay);
+	m_allocator->Free(m_minSeparations);
+	m_allocator->Free(m_constraints);
+}
+
+void b2ConstraintGraph::WarmStart()
+{
+	Run(e_warmStart);
+}
+
+void b2ConstraintGraph::SolveVelocityConstraints()
+{
+	Run(e_solveVelocity);
+}
+
+bool b2ConstraintGraph::SolvePositionConstraints()
+{
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		m_minSeparations[i] = 0.0f;
+		m_jointsOkay[i] = true;
+	}
+
+	Run(e_solvePosition);
+
+	float32 minSeparation = 0.0f;
+	bool jointsOkay = true;
+	for (int32 i = 0; i < m_threadCount; ++i)
+	{
+		minSeparation = b2Min(minSeparation, m_minSeparations[i]);
+		jointsOkay = jointsOkay && m_jointsOkay[i];
+	}
+
+	// As b2ContactSolver::SolvePositionConstraints.
+	return minSeparation >= -3.0f * b2_linearSlop && jointsOkay;
+}
+
+void b2ConstraintGraph::StoreImpulses()
+{
+	if (m_wideSolver)
+	{
+		m_wideSolver->StoreImpulses(0, m_wideSolver->m_count);
+	}
+}
+
+void b2ConstraintGraph::AddColors(b2Profile* profile) const
+{
+	profile->colorCount = b2Max(profile->colorCount, m_colorCount);
+	for (int32 i = 0; i < b2_graphColorCount; ++i)
+	{
+		profile->colorSizes[i] += m_colorStarts[i + 1] - m_colorStarts[i];
+	}
+	profile->colorOverflow += m_colorStarts[b2_graphColorCount + 1] - m_colorStarts[b2_graphColorCount];
+}
+
+// Moves the contacts of a color into wide batch order: full batches of two
+// point contacts, then of one point contacts, then the rest one by one.
+// Contacts of one color share no written body, so any order solves alike.
+void b2ConstraintGraph::Order(int32 color, bool wideSolve, int32* scratch)
+{
+	int32 begin = m_colorStarts[color];
+	int32 end = m_colorStarts[color + 1];
+	while (begin < end && m_constraints[begin] < 0)
+	{
+		++begin;
+	}
+
+	m_colorContacts[color] = begin;
+
+	int32 counts[b2_maxManifoldPoints + 1];
+	memset(counts, 0, sizeof(counts));
+	if (wideSolve)
+	{
+		for (int32 i = begin; i < end; ++i)
+		{
+			int32 pointCount = m_contactSolver->m_velocityConstraints[m_constraints[i]].pointCount;
+			if (pointCount == 1 || (pointCount == 2 && g_blockSolve))
+			{
+				++counts[pointCount];
+			}
+		}
+	}
+
+	int32 wide2 = counts[2] - counts[2] % b2_simdWidth;
+	int32 wide1 = counts[1] - counts[1] % b2_simdWidth;
+
+	int32 cursors[3] = { begin, begin + wide2, begin + wide2 + wide1 };
+	int32 left[3] = { wide2, wide1, end - begin };
+	memcpy(scratch, m_constraints + begin, (end - begin) * sizeof(int32));
+	for (int32 i = 0; i < end - begin; ++i)
+	{
+		int32 pointCount = m_contactSolver->m_velocityConstraints[scratch[i]].pointCount;
+		int32 slot = pointCount == 2 && left[0] > 0 ? 0 : (pointCount == 1 && left[1] > 0 ? 1 : 2);
+		--left[slot];
+		m_constraints[cursors[slot]++] = scratch[i];
+	}
+
+	m_colorScalar[color] = begin + wide2 + wide1;
+	m_colorWide[color + 1] = m_colorWide[color] + (wide2 + wide1) / b2_simdWidth;
+}
+
+void b2ConstraintGraph::Run(Stage stage)
+{
+	m_stage = stage;
+
+	for (int32 i = 0; i < m_colorCount; ++i)
+	{
+		m_color = i;
+
+		// Joints have no warm start here, b2Island does it.
+		int32 jointCount = stage == e_warmStart ? 0 : m_colorContacts[i] - m_colorStarts[i];
+		m_jointTasks = (jointCount + b2_colorBatchSize - 1) / b2_colorBatchSize;
+
+		// Position solving keeps to the scalar path.
+		m_wideTasks = 0;
+		m_scalarBegin = m_colorContacts[i];
+		if (stage != e_solvePosition)
+		{
+			m_wideTasks = (m_colorWide[i + 1] - m_colorWide[i] + b2_wideTaskSize - 1) / b2_wideTaskSize;
+			m_scalarBegin = m_colorScalar[i];
+		}
+
+		int32 scalarCount = m_colorStarts[i + 1] - m_scalarBegin;
+		int32 taskCount = m_jointTasks + m_wideTasks + (scalarCount + b2_colorBatchSize - 1) / b2_colorBatchSize;
+		if (taskCount > 1)
+		{
+			m_scheduler->ParallelFor(this, taskCount);
+		}
+		else if (taskCount == 1)
+		{
+			Execute(0, 0);
+		}
+	}
+
+	Solve(m_colorStarts[b2_graphColorCount], m_colorStarts[b2_graphColorCount + 1], 0);
+}
+
+void b2ConstraintGraph::Execute(int32 index, int32 threadIndex)
+{
+	if (index < m_jointTasks)
+	{
+		int32 begin = m_colorStarts[m_color] + index * b2_colorBatchSize;
+		int32 end = b2Min(begin + b2_colorBatchSize, m_colorContacts[m_color]);
+		Solve(begin, end, threadIndex);
+		return;
+	}
+
+	index -= m_jointTasks;
+	if (index < m_wideTasks)
+	{
+		int32 begin = m_colorWide[m_color] + index * b2_wideTaskSize;
+		int32 end = b2Min(begin + b2_wideTaskSize, m_colorWide[m_color + 1]);
+		if (m_stage == e_warmStart)
+		{
+			m_wideSolver->WarmStart(begin, end);
+		}
+		else
+		{
+			m_wideSolver->SolveVelocityConstraints(begin, end);
+		}
+		return;
+	}
+
+	index -= m_wideTasks;
+	int32 begin = m_scalarBegin + index * b2_colorBatchSize;
+	int32 end = b2Min(begin + b2_colorBatchSize, m_colorStarts[m_color + 1]);
+	Solve(begin, end, threadIndex);
+}
+
+void b2ConstraintGraph::Solve(int32 begin, int32 end, int32 threadIndex)
+{
+	// Joints lead each color, so a range is some joints then some contacts.
+	int32 i = begin;
+	for (; i < end && m_constraints[i] < 0; ++i)
+	{
+		b2Joint* joint = m_joints[-1 - m_constraints[i]];
+		if (m_stage == e_solveVelocity)
+		{
+			joint->SolveVelocityConstraints(m_data);
+		}
+		else if (m_stage == e_solvePosition)
+		{
+			bool jointOkay = joint->SolvePositionConstraints(m_data);
+			m_jointsOkay[threadIndex] = m_jointsOkay[threadIndex] && jointOkay;
+		}
+	}
+
+	const int32* contacts = m_constraints + i;
+	int32 contactCount = end - i;
+
+	switch (m_stage)
+	{
+	case e_warmStart:
+		m_contactSolver->WarmStart(contacts, contactCount);
+		break;
+
+	case e_solveVelocity:
+		m_contactSolver->SolveVelocityConstraints(contacts, contactCount);
+		break;
+
+	case e_solvePosition:
+		{
+			float32 minSeparation = m_contactSolver->SolvePositionConstraints(contacts, contactCount);
+			m_minSeparations[threadIndex] = b2Min(m_minSeparations[threadIndex], minSeparation);
+		}
+		break;
+	}
+}
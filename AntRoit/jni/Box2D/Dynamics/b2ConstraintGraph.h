@@ -0,0 +1,110 @@
+/*
+* Copyright (c) 2006-2011 Erin Catto http://www.box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_CONSTRAINT_GRAPH_H
+#define B2_CONSTRAINT_GRAPH_H
+
+#include <Box2D/Common/b2TaskScheduler.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
+
+class b2ContactSolver;
+class b2Joint;
+class b2StackAllocator;
+class b2WideContactSolver;
+
+/// Groups an island's contacts and joints into colors, so that no two
+/// constraints of one color write the same body, and solves the colors in
+/// turn with each color spread over the task scheduler's threads. Contacts
+/// only read bodies without mass, so any number of them in a color share
+/// the ground; joints write both their bodies. Colors are picked greedily
+/// in constraint order, so the result does not depend on the thread count.
+/// Contacts of a color also fill wide batches for b2WideContactSolver,
+/// which does the velocity work a batch of contacts at a time.
+/// This is an internal class.
+class b2ConstraintGraph : public b2Task
+{
+public:
+	/// Joints read their bodies' m_islandIndex, which must be this island's.
+	/// With wideSolve, contacts are also packed into wide batches.
+	b2ConstraintGraph(b2ContactSolver* contactSolver, b2Joint** joints, int32 jointCount, int32 bodyCount,
+					const b2SolverData& data, b2TaskScheduler* scheduler, bool wideSolve, b2StackAllocator* allocator);
+	~b2ConstraintGraph();
+
+	/// Warm start the contacts. Joints warm start when initialized.
+	void WarmStart();
+
+	/// One velocity iteration over all joints and contacts.
+	void SolveVelocityConstraints();
+
+	/// Copy the wide batches' impulses back to the contact solver.
+	void StoreImpulses();
+
+	/// One position iteration. Returns true once the errors are small.
+	bool SolvePositionConstraints();
+
+	/// Add the color count and sizes to the profile.
+	void AddColors(b2Profile* profile) const;
+
+	void Execute(int32 index, int32 threadIndex);
+
+private:
+	enum Stage
+	{
+		e_warmStart,
+		e_solveVelocity,
+		e_solvePosition
+	};
+
+	void Run(Stage stage);
+	void Solve(int32 begin, int32 end, int32 threadIndex);
+	void Order(int32 color, bool wideSolve, int32* scratch);
+
+	b2ContactSolver* m_contactSolver;
+	b2Joint** m_joints;
+	b2SolverData m_data;
+	b2TaskScheduler* m_scheduler;
+	b2StackAllocator* m_allocator;
+
+	// Constraints by color, contact indices as is and joint indices as
+	// -1 - index. Each color lists its joints, then the contacts packed
+	// into wide batches, then those solved one by one. The overflow of
+	// constraints that fit in no color follows the last color.
+	int32* m_constraints;
+	int32 m_colorStarts[b2_graphColorCount + 2];
+	int32 m_colorContacts[b2_graphColorCount];
+	int32 m_colorScalar[b2_graphColorCount];
+	int32 m_colorWide[b2_graphColorCount + 1];
+	int32 m_colorCount;
+
+	b2WideContactSolver* m_wideSolver;
+
+	// The stage and color being run, split into tasks of joints, of wide
+	// batches and of single contacts in that order.
+	Stage m_stage;
+	int32 m_color;
+	int32 m_jointTasks;
+	int32 m_wideTasks;
+	int32 m_scalarBegin;
+
+	// Position iteration results of each thread.
+	int32 m_threadCount;
+	float32* m_minSeparations;
+	bool* m_jointsOkay;
+};
+
+#endif
@@ -21,6 +21,8 @@
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2TaskScheduler.h>
 
 b2ContactFilter b2_defaultFilter;
 b2ContactListener b2_defaultListener;
@@ -32,6 +34,8 @@ b2ContactManager::b2ContactManager()
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+	m_stackAllocator = NULL;
+	m_taskScheduler = NULL;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -104,69 +108,202 @@ void b2ContactManager::Destroy(b2Contact* c)
 // contact list.
 void b2ContactManager::Collide()
 {
+	if (m_taskScheduler && m_taskScheduler->GetThreadCount() > 1 && m_contactCount >= 2 * b2_collideBatchSize)
+	{
+		CollideParallel();
+		return;
+	}
+
 	// Update awake contacts.
 	b2Contact* c = m_contactList;
 	while (c)
 	{
-		b2Fixture* fixtureA = c->GetFixtureA();
-		b2Fixture* fixtureB = c->GetFixtureB();
-		int32 indexA = c->GetChildIndexA();
-		int32 indexB = c->GetChildIndexB();
-		b2Body* bodyA = fixtureA->GetBody();
-		b2Body* bodyB = fixtureB->GetBody();
-		 
-		// Is this contact flagged for filtering?
-		if (c->m_flags & b2Contact::e_filterFlag)
-		{
-			// Should these bodies collide?
-			if (bodyB->ShouldCollide(bodyA) == false)
-			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
-				continue;
-			}
+		b2Contact* next = c->GetNext();
+		Collide(c);
+		c = next;
+	}
+}
 
-			// Check user filtering.
-			if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
-			{
-				b2Contact* cNuke = c;
-				c = cNuke->GetNext();
-				Destroy(cNuke);
-				continue;
-			}
+bool b2ContactManager::Collide(b2Contact* c)
+{
+	b2Fixture* fixtureA = c->GetFixtureA();
+	b2Fixture* fixtureB = c->GetFixtureB();
+	int32 indexA = c->GetChildIndexA();
+	int32 indexB = c->GetChildIndexB();
+	b2Body* bodyA = fixtureA->GetBody();
+	b2Body* bodyB = fixtureB->GetBody();
+	 
+	// Is this contact flagged for filtering?
+	if (c->m_flags & b2Contact::e_filterFlag)
+	{
+		// Should these bodies collide?
+		if (bodyB->ShouldCollide(bodyA) == false)
+		{
+			Destroy(c);
+			return false;
+		}
 
-			// Clear the filtering flag.
-			c->m_flags &= ~b2Contact::e_filterFlag;
+		// Check user filtering.
+		if (m_contactFilter && m_contactFilter->ShouldCollide(fixtureA, fixtureB) == false)
+		{
+			Destroy(c);
+			return false;
 		}
 
-		bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
-		bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+		// Clear the filtering flag.
+		c->m_flags &= ~b2Contact::e_filterFlag;
+	}
+
+	bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+	bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+
+	// At least one body must be awake and it must be dynamic or kinematic.
+	if (activeA == false && activeB == false)
+	{
+		return true;
+	}
+
+	int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
+	int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
+	bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+
+	// Here we destroy contacts that cease to overlap in the broad-phase.
+	if (overlap == false)
+	{
+		Destroy(c);
+		return false;
+	}
+
+	// The contact persists.
+	c->Update(m_contactListener);
+	return true;
+}
 
-		// At least one body must be awake and it must be dynamic or kinematic.
-		if (activeA == false && activeB == false)
+// What the concurrent pass decided for one contact.
+enum b2CollideResult
+{
+	// Left to the serial pass: flagged for filtering, which calls the
+	// contact filter, or asleep, as an earlier contact may wake it.
+	e_collideSerial,
+	e_collideDestroy,
+	e_collideUpdated
+};
+
+int32 b2ContactManager::CollideConcurrent(b2Contact* c, bool* wasTouching, b2Manifold* oldManifold) const
+{
+	b2Fixture* fixtureA = c->GetFixtureA();
+	b2Fixture* fixtureB = c->GetFixtureB();
+	b2Body* bodyA = fixtureA->GetBody();
+	b2Body* bodyB = fixtureB->GetBody();
+
+	bool activeA = bodyA->IsAwake() && bodyA->m_type != b2_staticBody;
+	bool activeB = bodyB->IsAwake() && bodyB->m_type != b2_staticBody;
+
+	if ((c->m_flags & b2Contact::e_filterFlag) || (activeA == false && activeB == false))
+	{
+		return e_collideSerial;
+	}
+
+	int32 proxyIdA = fixtureA->m_proxies[c->GetChildIndexA()].proxyId;
+	int32 proxyIdB = fixtureB->m_proxies[c->GetChildIndexB()].proxyId;
+	if (m_broadPhase.TestOverlap(proxyIdA, proxyIdB) == false)
+	{
+		return e_collideDestroy;
+	}
+
+	*wasTouching = c->UpdateManifold(oldManifold);
+	return e_collideUpdated;
+}
+
+class b2CollideTask : public b2Task
+{
+public:
+	void Execute(int32 index, int32 threadIndex)
+	{
+		B2_NOT_USED(threadIndex);
+
+		int32 end = b2Min((index + 1) * b2_collideBatchSize, count);
+		for (int32 i = index * b2_collideBatchSize; i < end; ++i)
 		{
-			c = c->GetNext();
-			continue;
+			results[i] = (uint8)manager->CollideConcurrent(contacts[i], wasTouching + i, oldManifolds + i);
 		}
+	}
+
+	const b2ContactManager* manager;
+	b2Contact** contacts;
+	int32 count;
+	uint8* results;
+	bool* wasTouching;
+	b2Manifold* oldManifolds;
+};
 
-		int32 proxyIdA = fixtureA->m_proxies[indexA].proxyId;
-		int32 proxyIdB = fixtureB->m_proxies[indexB].proxyId;
-		bool overlap = m_broadPhase.TestOverlap(proxyIdA, proxyIdB);
+void b2ContactManager::CollideParallel()
+{
+	int32 count = m_contactCount;
+	b2Contact** contacts = (b2Contact**)m_stackAllocator->Allocate(count * sizeof(b2Contact*));
+	uint8* results = (uint8*)m_stackAllocator->Allocate(count * sizeof(uint8));
+	bool* wasTouching = (bool*)m_stackAllocator->Allocate(count * sizeof(bool));
+	b2Manifold* oldManifolds = (b2Manifold*)m_stackAllocator->Allocate(count * sizeof(b2Manifold));
+
+	int32 i = 0;
+	for (b2Contact* c = m_contactList; c; c = c->GetNext())
+	{
+		contacts[i++] = c;
+	}
+	b2Assert(i == count);
+
+	b2CollideTask task;
+	task.manager = this;
+	task.contacts = contacts;
+	task.count = count;
+	task.results = results;
+	task.wasTouching = wasTouching;
+	task.oldManifolds = oldManifolds;
+	m_taskScheduler->ParallelFor(&task, (count + b2_collideBatchSize - 1) / b2_collideBatchSize);
+
+	// Replay in list order, so bodies woken and listener calls made by
+	// earlier contacts are seen by later ones exactly as in Collide().
+	for (i = 0; i < count; ++i)
+	{
+		b2Contact* c = contacts[i];
 
-		// Here we destroy contacts that cease to overlap in the broad-phase.
-		if (overlap == false)
+		switch (results[i])
 		{
-			b2Contact* cNuke = c;
-			c = cNuke->GetNext();
-			Destroy(cNuke);
-			continue;
-		}
+		case e_collideSerial:
+			Collide(c);
+			break;
+
+		case e_collideDestroy:
+			Destroy(c);
+			break;
 
-		// The contact persists.
-		c->Update(m_contactListener);
-		c = c->GetNext();
+		case e_collideUpdated:
+			if (c->m_flags & b2Contact::e_filterFlag)
+			{
+				// An earlier contact's listener changed the filter data since
+				// the concurrent pass. Undo the update and filter it first.
+				c->m_manifold = oldManifolds[i];
+				if (wasTouching[i])
+				{
+					c->m_flags |= b2Contact::e_touchingFlag;
+				}
+				else
+				{
+					c->m_flags &= ~b2Contact::e_touchingFlag;
+				}
+				Collide(c);
+				break;
+			}
+
+			c->ReportUpdate(m_contactListener, oldManifolds[i], wasTouching[i]);
+			break;
+		}
 	}
+
+	m_stackAllocator->Free(oldManifolds);
+	m_stackAllocator->Free(wasTouching);
+	m_stackAllocator->Free(results);
+	m_stackAllocator->Free(contacts);
 }
 
 void b2ContactManager::FindNewContacts()
@@ -25,6 +25,9 @@ class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+class b2StackAllocator;
+class b2TaskScheduler;
+struct b2Manifold;
 
 // Delegate of b2World.
 class b2ContactManager
@@ -40,6 +43,20 @@ public:
 	void Destroy(b2Contact* c);
 
 	void Collide();
+
+	// Runs the serial narrow phase for one contact. Returns false if the
+	// contact was destroyed.
+	bool Collide(b2Contact* c);
+
+	// With more than one thread, Collide updates manifolds concurrently
+	// and then destroys contacts and calls the listener serially, in
+	// contact list order.
+	void CollideParallel();
+
+	// The part of Collide(c) that CollideParallel runs concurrently: no
+	// user callbacks, no destruction and no writes outside the contact.
+	// Returns a b2CollideResult.
+	int32 CollideConcurrent(b2Contact* c, bool* wasTouching, b2Manifold* oldManifold) const;
             
 	b2BroadPhase m_broadPhase;
 	b2Contact* m_contactList;
@@ -47,6 +64,8 @@ public:
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+	b2StackAllocator* m_stackAllocator;
+	b2TaskScheduler* m_taskScheduler;
 };
 
 #endif
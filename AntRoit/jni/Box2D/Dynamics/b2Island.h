@@ -27,7 +27,9 @@ class b2Contact;
 class b2Joint;
 class b2StackAllocator;
 class b2ContactListener;
+class b2TaskScheduler;
 struct b2ContactVelocityConstraint;
+struct b2ContactImpulse;
 struct b2Profile;
 
 /// This is an internal class.
@@ -74,6 +76,21 @@ public:
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
+	// Set when islands are solved concurrently. Static bodies belong to
+	// several islands at once, so their m_islandIndex is only valid for
+	// the last island built; m_contactIndices holds the body indices of
+	// each contact instead. With m_impulses set, Report stores the
+	// impulses there for the world to pass to the listener afterwards.
+	const int32* m_contactIndices;
+	b2ContactImpulse* m_impulses;
+
+	// Set to graph color the constraints and solve each color on this
+	// scheduler. Joints must see this island's m_islandIndex.
+	b2TaskScheduler* m_taskScheduler;
+
+	// Set to solve colored contact velocities on wide batches.
+	bool m_wideSolve;
+
 	b2Body** m_bodies;
 	b2Contact** m_contacts;
 	b2Joint** m_joints;
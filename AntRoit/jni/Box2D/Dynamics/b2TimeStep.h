@@ -32,6 +32,12 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+
+	// Graph colors used by the colored islands, the contacts and joints in
+	// each, and those that fit in no color. Summed over colored islands.
+	int32 colorCount;
+	int32 colorSizes[b2_graphColorCount];
+	int32 colorOverflow;
 };
 
 /// This is an internal structure.
@@ -23,6 +23,7 @@
 #include <Box2D/Dynamics/Joints/b2PulleyJoint.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 #include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <Box2D/Dynamics/Contacts/b2WideContactSolver.h>
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/b2BroadPhase.h>
 #include <Box2D/Collision/Shapes/b2CircleShape.h>
@@ -33,6 +34,7 @@
 #include <Box2D/Common/b2Draw.h>
 #include <Box2D/Common/b2Timer.h>
 #include <new>
+#include <algorithm>
 
 b2World::b2World(const b2Vec2& gravity)
 {
@@ -60,6 +62,16 @@ b2World::b2World(const b2Vec2& gravity)
 
 	m_contactManager.m_allocator = &m_blockAllocator;
 
+	m_taskScheduler = &m_threadPool;
+	m_contactManager.m_stackAllocator = &m_stackAllocator;
+	m_contactManager.m_taskScheduler = m_taskScheduler;
+	m_contactManager.m_broadPhase.SetTaskScheduler(m_taskScheduler);
+	m_threadAllocators = NULL;
+	m_threadAllocatorCount = 0;
+
+	m_graphColoring = false;
+	m_wideSolve = b2_simdVector != 0;
+
 	memset(&m_profile, 0, sizeof(b2Profile));
 }
 
@@ -82,6 +94,12 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+	{
+		m_threadAllocators[i].~b2StackAllocator();
+	}
+	b2Free(m_threadAllocators);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -99,6 +117,53 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactManager.m_contactListener = listener;
 }
 
+void b2World::SetTaskScheduler(b2TaskScheduler* scheduler)
+{
+	b2Assert(IsLocked() == false);
+	m_taskScheduler = scheduler ? scheduler : &m_threadPool;
+	m_contactManager.m_taskScheduler = m_taskScheduler;
+	m_contactManager.m_broadPhase.SetTaskScheduler(m_taskScheduler);
+}
+
+void b2World::SetThreadCount(int32 count)
+{
+	b2Assert(IsLocked() == false);
+	m_threadPool.SetThreadCount(b2Max(count, 1));
+}
+
+void b2World::SetGraphColoring(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	m_graphColoring = flag;
+}
+
+void b2World::SetWideSolve(bool flag)
+{
+	b2Assert(IsLocked() == false);
+	m_wideSolve = flag;
+}
+
+b2StackAllocator* b2World::GetThreadAllocators(int32 count)
+{
+	if (count > m_threadAllocatorCount)
+	{
+		for (int32 i = 0; i < m_threadAllocatorCount; ++i)
+		{
+			m_threadAllocators[i].~b2StackAllocator();
+		}
+		b2Free(m_threadAllocators);
+
+		m_threadAllocators = (b2StackAllocator*)b2Alloc(count * sizeof(b2StackAllocator));
+		for (int32 i = 0; i < count; ++i)
+		{
+			new (m_threadAllocators + i) b2StackAllocator();
+		}
+		m_threadAllocatorCount = count;
+	}
+
+	return m_threadAllocators;
+}
+
 void b2World::SetDebugDraw(b2Draw* debugDraw)
 {
 	g_debugDraw = debugDraw;
@@ -383,18 +448,105 @@ void b2World::SetAllowSleeping(bool flag)
 }
 
 // Find islands, integrate and solve constraints, solve position constraints
+// One awake island found by the depth first search in b2World::Solve, as
+// ranges of the flat buffers all islands are gathered into.
+struct b2IslandRange
+{
+	int32 bodyStart, bodyCount;
+	int32 contactStart, contactCount;
+	int32 jointStart, jointCount;
+
+	// A joint reaches a static body. Joints read m_islandIndex from their
+	// bodies, which is only right for a shared static body while nothing
+	// else runs, so such islands are solved after the concurrent batch.
+	bool serial;
+
+	// Big enough to graph color. Solved after the concurrent batch too,
+	// with each color spread over the threads instead.
+	bool colored;
+
+	b2Profile profile;
+};
+
+// Orders island indices by decreasing size.
+struct b2IslandOrder
+{
+	b2IslandOrder(const b2IslandRange* islands) : islands(islands) {}
+
+	bool operator()(int32 a, int32 b) const
+	{
+		int32 sizeA = islands[a].bodyCount + islands[a].contactCount + islands[a].jointCount;
+		int32 sizeB = islands[b].bodyCount + islands[b].contactCount + islands[b].jointCount;
+		return sizeA != sizeB ? sizeA > sizeB : a < b;
+	}
+
+	const b2IslandRange* islands;
+};
+
+// Solves gathered islands. Islands share no dynamic bodies, contacts or
+// joints, and static bodies are only read, so the result does not depend
+// on which thread solves which island or in what order.
+class b2SolveIslandTask : public b2Task
+{
+public:
+	void Execute(int32 index, int32 threadIndex)
+	{
+		b2IslandRange* range = islands + order[index];
+		if (range->serial || range->colored)
+		{
+			return;
+		}
+
+		Solve(range, allocators + threadIndex, NULL);
+	}
+
+	void Solve(b2IslandRange* range, b2StackAllocator* allocator, b2TaskScheduler* scheduler)
+	{
+		b2Island island(range->bodyCount, range->contactCount, range->jointCount, allocator, listener);
+
+		// Copied rather than added, as adding sets m_islandIndex.
+		memcpy(island.m_bodies, bodies + range->bodyStart, range->bodyCount * sizeof(b2Body*));
+		memcpy(island.m_contacts, contacts + range->contactStart, range->contactCount * sizeof(b2Contact*));
+		memcpy(island.m_joints, joints + range->jointStart, range->jointCount * sizeof(b2Joint*));
+		island.m_bodyCount = range->bodyCount;
+		island.m_contactCount = range->contactCount;
+		island.m_jointCount = range->jointCount;
+
+		island.m_contactIndices = contactIndices + 2 * range->contactStart;
+		island.m_impulses = impulses ? impulses + range->contactStart : NULL;
+		island.m_taskScheduler = scheduler;
+		island.m_wideSolve = wideSolve;
+
+		island.Solve(&range->profile, *step, gravity, allowSleep);
+	}
+
+	const b2TimeStep* step;
+	b2Vec2 gravity;
+	bool allowSleep;
+	bool wideSolve;
+	b2ContactListener* listener;
+
+	b2IslandRange* islands;
+	int32* order;
+	b2Body** bodies;
+	b2Contact** contacts;
+	int32* contactIndices;
+	b2Joint** joints;
+	b2ContactImpulse* impulses;
+	b2StackAllocator* allocators;
+};
+
 void b2World::Solve(const b2TimeStep& step)
 {
 	m_profile.solveInit = 0.0f;
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
+	m_profile.colorCount = 0;
+	memset(m_profile.colorSizes, 0, sizeof(m_profile.colorSizes));
+	m_profile.colorOverflow = 0;
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount,
-					m_contactManager.m_contactCount,
-					m_jointCount,
-					&m_stackAllocator,
-					m_contactManager.m_contactListener);
+	int32 contactCount = m_contactManager.m_contactCount;
+	b2ContactListener* listener = m_contactManager.m_contactListener;
 
 	// Clear all the island flags.
 	for (b2Body* b = m_bodyList; b; b = b->m_next)
@@ -410,7 +562,24 @@ void b2World::Solve(const b2TimeStep& step)
 		j->m_islandFlag = false;
 	}
 
-	// Build and simulate all awake islands.
+	// Every island lists its static bodies once each, and reaches each of
+	// them through a contact or joint, which bounds the body entries.
+	int32 bodyCapacity = m_bodyCount + contactCount + m_jointCount;
+
+	b2IslandRange* islands = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+	int32* order = (int32*)m_stackAllocator.Allocate(m_bodyCount * sizeof(int32));
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(bodyCapacity * sizeof(b2Body*));
+	b2Contact** contacts = (b2Contact**)m_stackAllocator.Allocate(contactCount * sizeof(b2Contact*));
+	int32* contactIndices = (int32*)m_stackAllocator.Allocate(2 * contactCount * sizeof(int32));
+	b2Joint** joints = (b2Joint**)m_stackAllocator.Allocate(m_jointCount * sizeof(b2Joint*));
+	b2ContactImpulse* impulses = listener ? (b2ContactImpulse*)m_stackAllocator.Allocate(contactCount * sizeof(b2ContactImpulse)) : NULL;
+
+	int32 islandCount = 0;
+	int32 bodyTotal = 0;
+	int32 contactTotal = 0;
+	int32 jointTotal = 0;
+
+	// Build all awake islands.
 	int32 stackSize = m_bodyCount;
 	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
 	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
@@ -431,8 +600,13 @@ void b2World::Solve(const b2TimeStep& step)
 			continue;
 		}
 
-		// Reset island and stack.
-		island.Clear();
+		b2IslandRange* range = islands + islandCount++;
+		range->bodyStart = bodyTotal;
+		range->contactStart = contactTotal;
+		range->jointStart = jointTotal;
+		range->serial = false;
+
+		// Reset stack.
 		int32 stackCount = 0;
 		stack[stackCount++] = seed;
 		seed->m_flags |= b2Body::e_islandFlag;
@@ -443,7 +617,9 @@ void b2World::Solve(const b2TimeStep& step)
 			// Grab the next body off the stack and add it to the island.
 			b2Body* b = stack[--stackCount];
 			b2Assert(b->IsActive() == true);
-			island.Add(b);
+			b2Assert(bodyTotal < bodyCapacity);
+			b->m_islandIndex = bodyTotal - range->bodyStart;
+			bodies[bodyTotal++] = b;
 
 			// Make sure the body is awake.
 			b->SetAwake(true);
@@ -481,7 +657,7 @@ void b2World::Solve(const b2TimeStep& step)
 					continue;
 				}
 
-				island.Add(contact);
+				contacts[contactTotal++] = contact;
 				contact->m_flags |= b2Contact::e_islandFlag;
 
 				b2Body* other = ce->other;
@@ -513,9 +689,14 @@ void b2World::Solve(const b2TimeStep& step)
 					continue;
 				}
 
-				island.Add(je->joint);
+				joints[jointTotal++] = je->joint;
 				je->joint->m_islandFlag = true;
 
+				if (other->GetType() == b2_staticBody)
+				{
+					range->serial = true;
+				}
+
 				if (other->m_flags & b2Body::e_islandFlag)
 				{
 					continue;
@@ -527,17 +708,23 @@ void b2World::Solve(const b2TimeStep& step)
 			}
 		}
 
-		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
-		m_profile.solveInit += profile.solveInit;
-		m_profile.solveVelocity += profile.solveVelocity;
-		m_profile.solvePosition += profile.solvePosition;
+		range->bodyCount = bodyTotal - range->bodyStart;
+		range->contactCount = contactTotal - range->contactStart;
+		range->jointCount = jointTotal - range->jointStart;
+		range->colored = m_graphColoring && range->contactCount + range->jointCount >= b2_graphColorMinConstraints;
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		// Static bodies hold this island's indices until the next island
+		// is built; keep them with the contacts.
+		for (int32 i = range->contactStart; i < contactTotal; ++i)
 		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
+			contactIndices[2 * i] = contacts[i]->m_fixtureA->m_body->m_islandIndex;
+			contactIndices[2 * i + 1] = contacts[i]->m_fixtureB->m_body->m_islandIndex;
+		}
+
+		// Allow static bodies to participate in other islands.
+		for (int32 i = range->bodyStart; i < bodyTotal; ++i)
+		{
+			b2Body* b = bodies[i];
 			if (b->GetType() == b2_staticBody)
 			{
 				b->m_flags &= ~b2Body::e_islandFlag;
@@ -547,6 +734,95 @@ void b2World::Solve(const b2TimeStep& step)
 
 	m_stackAllocator.Free(stack);
 
+	int32 threadCount = m_taskScheduler->GetThreadCount();
+
+	// Hand out the largest islands first so one big island started last
+	// does not leave the other threads idle.
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		order[i] = i;
+	}
+	if (threadCount > 1)
+	{
+		std::sort(order, order + islandCount, b2IslandOrder(islands));
+	}
+
+	b2SolveIslandTask task;
+	task.step = &step;
+	task.gravity = m_gravity;
+	task.allowSleep = m_allowSleep;
+	task.wideSolve = m_wideSolve;
+	task.listener = listener;
+	task.islands = islands;
+	task.order = order;
+	task.bodies = bodies;
+	task.contacts = contacts;
+	task.contactIndices = contactIndices;
+	task.joints = joints;
+	task.impulses = impulses;
+	task.allocators = GetThreadAllocators(threadCount);
+
+	m_taskScheduler->ParallelFor(&task, islandCount);
+
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		b2IslandRange* range = islands + i;
+		if (range->serial == false && range->colored == false)
+		{
+			continue;
+		}
+
+		for (int32 j = 0; j < range->bodyCount; ++j)
+		{
+			bodies[range->bodyStart + j]->m_islandIndex = j;
+		}
+
+		range->profile.colorCount = 0;
+		memset(range->profile.colorSizes, 0, sizeof(range->profile.colorSizes));
+		range->profile.colorOverflow = 0;
+
+		task.Solve(range, task.allocators, range->colored ? m_taskScheduler : NULL);
+	}
+
+	// Sum the profiles and report impulses in island order, as solving
+	// each island in turn would have.
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		b2IslandRange* range = islands + i;
+		m_profile.solveInit += range->profile.solveInit;
+		m_profile.solveVelocity += range->profile.solveVelocity;
+		m_profile.solvePosition += range->profile.solvePosition;
+
+		if (range->colored)
+		{
+			m_profile.colorCount = b2Max(m_profile.colorCount, range->profile.colorCount);
+			for (int32 j = 0; j < b2_graphColorCount; ++j)
+			{
+				m_profile.colorSizes[j] += range->profile.colorSizes[j];
+			}
+			m_profile.colorOverflow += range->profile.colorOverflow;
+		}
+
+		if (listener)
+		{
+			for (int32 j = range->contactStart; j < range->contactStart + range->contactCount; ++j)
+			{
+				listener->PostSolve(contacts[j], impulses + j);
+			}
+		}
+	}
+
+	if (impulses)
+	{
+		m_stackAllocator.Free(impulses);
+	}
+	m_stackAllocator.Free(joints);
+	m_stackAllocator.Free(contactIndices);
+	m_stackAllocator.Free(contacts);
+	m_stackAllocator.Free(bodies);
+	m_stackAllocator.Free(order);
+	m_stackAllocator.Free(islands);
+
 	{
 		b2Timer timer;
 		// Synchronize fixtures, check for out of range bodies.
@@ -22,6 +22,7 @@
 #include <Box2D/Common/b2Math.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Common/b2StackAllocator.h>
+#include <Box2D/Common/b2TaskScheduler.h>
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/b2TimeStep.h>
@@ -61,6 +62,34 @@ public:
 	/// remain in scope.
 	void SetContactListener(b2ContactListener* listener);
 
+	/// Run the world's parallel work, such as solving islands, on your own
+	/// scheduler. Pass NULL to go back to the built-in thread pool. The
+	/// scheduler is owned by you and must remain in scope.
+	void SetTaskScheduler(b2TaskScheduler* scheduler);
+
+	/// Set the thread count of the built-in thread pool, including the
+	/// thread calling Step. The default of 1 solves everything on the caller.
+	/// Results do not depend on the thread count.
+	void SetThreadCount(int32 count);
+
+	/// Get the thread count of the current task scheduler.
+	int32 GetThreadCount() const;
+
+	/// Graph color the contacts and joints of islands with at least
+	/// b2_graphColorMinConstraints of them, and solve each color on all
+	/// threads. This helps when one island holds most of the bodies. Colored
+	/// islands solve their constraints in another order, so this changes
+	/// results, but they still do not depend on the thread count.
+	void SetGraphColoring(bool flag);
+	bool GetGraphColoring() const;
+
+	/// Solve the contact velocities of graph colored islands on wide SIMD
+	/// batches, b2_simdWidth contacts at a time. Results are the same as
+	/// without. On by default where the lanes are vector registers
+	/// (b2_simdVector); elsewhere the plain float lanes are slower.
+	void SetWideSolve(bool flag);
+	bool GetWideSolve() const;
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside with b2World::DrawDebugData method. The debug draw object is owned
 	/// by you and must remain in scope.
@@ -227,12 +256,21 @@ private:
 	void Solve(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
+	b2StackAllocator* GetThreadAllocators(int32 count);
+
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Fixture* shape, const b2Transform& xf, const b2Color& color);
 
 	b2BlockAllocator m_blockAllocator;
 	b2StackAllocator m_stackAllocator;
 
+	b2ThreadPool m_threadPool;
+	b2TaskScheduler* m_taskScheduler;
+
+	// Per thread scratch for solving islands concurrently.
+	b2StackAllocator* m_threadAllocators;
+	int32 m_threadAllocatorCount;
+
 	int32 m_flags;
 
 	b2ContactManager m_contactManager;
@@ -260,6 +298,9 @@ private:
 
 	bool m_stepComplete;
 
+	bool m_graphColoring;
+	bool m_wideSolve;
+
 	b2Profile m_profile;
 };
 
@@ -346,6 +387,21 @@ inline const b2ContactManager& b2World::GetContactManager() const
 	return m_contactManager;
 }
 
+inline int32 b2World::GetThreadCount() const
+{
+	return m_taskScheduler->GetThreadCount();
+}
+
+inline bool b2World::GetGraphColoring() const
+{
+	return m_graphColoring;
+}
+
+inline bool b2World::GetWideSolve() const
+{
+	return m_wideSolve;
+}
+
 inline const b2Profile& b2World::GetProfile() const
 {
 	return m_profile;
@@ -33,14 +33,23 @@ public class AntRoitActivity extends Activity
 	protected void onCreate(Bundle savedInstanceState)
 	{
 		super.onCreate(savedInstanceState);
+		AntRoitLib.setCacheDirectory(getCacheDir().getAbsolutePath());
+		// One core stays with the renderer.
+		AntRoitLib.setPhysicsThreads(Math.max(Runtime.getRuntime().availableProcessors() - 1, 1));
+		// The box ends up as one pile, which only colors spread over threads.
+		AntRoitLib.setGraphColoring(Runtime.getRuntime().availableProcessors() > 2);
 		view = new AntRoitView(getApplication());
 		setContentView(view);
 	}
 
+	// The simulation thread is started and stopped only on the GL thread,
+	// which also rebuilds it on every new surface, so pause and resume are
+	// queued there. The GL thread runs queued events even while paused.
 	@Override
 	protected void onPause()
 	{
 		super.onPause();
+		view.queueEvent(pauseLib);
 		view.onPause();
 	}
 
@@ -49,5 +58,22 @@ public class AntRoitActivity extends Activity
 	{
 		super.onResume();
 		view.onResume();
+		view.queueEvent(resumeLib);
 	}
+
+	private final Runnable pauseLib = new Runnable()
+	{
+		public void run()
+		{
+			AntRoitLib.pause();
+		}
+	};
+
+	private final Runnable resumeLib = new Runnable()
+	{
+		public void run()
+		{
+			AntRoitLib.resume();
+		}
+	};
 }
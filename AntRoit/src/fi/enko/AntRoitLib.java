@@ -30,5 +30,17 @@ public class AntRoitLib {
      */
      public static native void init(int width, int height);
      public static native void step(long time);
-	 public static native void touch(float x, float y);
+	 public static native void touch(int action, float x, float y, long eventTime);
+	 public static native void setPhysicsRate(float hz);
+	 public static native void setPopulation(int cap, int policy);
+	 public static native void setStepBudget(float milliseconds);
+	 public static native void setPhysicsThreads(int count);
+	 public static native void setGraphColoring(boolean enabled);
+	 public static native void pause();
+	 public static native void resume();
+	 public static native void setCacheDirectory(String path);
+	 public static native void setRecordPath(String path);
+	 public static native String getTelemetry();
+	 public static native boolean isIdle();
+	 public static native int getWakeDelay();
 }
\ No newline at end of file
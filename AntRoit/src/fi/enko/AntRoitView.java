@@ -39,7 +39,6 @@ import android.util.AttributeSet;
 import android.util.Log;
 import android.view.KeyEvent;
 import android.view.MotionEvent;
-import android.os.SystemClock;
 
 import javax.microedition.khronos.egl.EGL10;
 import javax.microedition.khronos.egl.EGLConfig;
@@ -72,7 +71,7 @@ class AntRoitView extends GLSurfaceView {
 
     public AntRoitView(Context context) {
         super(context);
-        init(false, 0, 0);
+        init(false, 16, 0);
     }
 
     public AntRoitView(Context context, boolean translucent, int depth, int stencil) {
@@ -105,7 +104,7 @@ class AntRoitView extends GLSurfaceView {
                              new ConfigChooser(5, 6, 5, 0, depth, stencil) );
 
         /* Set the renderer responsible for frame rendering */
-        setRenderer(new Renderer());
+        setRenderer(new Renderer(this));
     }
 
     private static class ContextFactory implements GLSurfaceView.EGLContextFactory {
@@ -135,10 +134,18 @@ class AntRoitView extends GLSurfaceView {
 	@Override
 	public boolean onTouchEvent(MotionEvent event)
 	{
-		if(event.getAction() == 1)
+		// Down, up and move map to the native input types; a cancel lets go.
+		int action = event.getActionMasked();
+		if (action == MotionEvent.ACTION_CANCEL)
 		{
-			AntRoitLib.touch(event.getX(), event.getY());
+			action = MotionEvent.ACTION_UP;
 		}
+
+		if (action == MotionEvent.ACTION_DOWN || action == MotionEvent.ACTION_UP || action == MotionEvent.ACTION_MOVE)
+		{
+			AntRoitLib.touch(action, event.getX(), event.getY(), event.getEventTime());
+		}
+		setRenderMode(RENDERMODE_CONTINUOUSLY);
 		return true;
 	}
 
@@ -336,8 +343,28 @@ class AntRoitView extends GLSurfaceView {
     }
 
     private static class Renderer implements GLSurfaceView.Renderer {
+        public Renderer(GLSurfaceView view) {
+            mView = view;
+        }
+
         public void onDrawFrame(GL10 gl) {
-            AntRoitLib.step(SystemClock.elapsedRealtime());
+            AntRoitLib.step(System.nanoTime());
+
+            // Every body asleep: stop redrawing identical frames until the
+            // next spawn or a touch.
+            if (AntRoitLib.isIdle()) {
+                if (mView.getRenderMode() != RENDERMODE_WHEN_DIRTY) {
+                    mView.setRenderMode(RENDERMODE_WHEN_DIRTY);
+                }
+
+                int delay = AntRoitLib.getWakeDelay();
+                if (delay >= 0) {
+                    mView.removeCallbacks(mWake);
+                    mView.postDelayed(mWake, delay);
+                }
+            } else if (mView.getRenderMode() != RENDERMODE_CONTINUOUSLY) {
+                mView.setRenderMode(RENDERMODE_CONTINUOUSLY);
+            }
         }
 
         public void onSurfaceChanged(GL10 gl, int width, int height) {
@@ -347,5 +374,13 @@ class AntRoitView extends GLSurfaceView {
         public void onSurfaceCreated(GL10 gl, EGLConfig config) {
             // Do nothing.
         }
+
+        private final Runnable mWake = new Runnable() {
+            public void run() {
+                mView.requestRender();
+            }
+        };
+
+        private GLSurfaceView mView;
     }
 }